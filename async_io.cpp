@@ -0,0 +1,240 @@
+#include "../include/async_io.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef RGR_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+std::runtime_error systemError(const std::string& what, int error) {
+    return std::runtime_error(what + ": " + std::strerror(error));
+}
+
+// Указатель на поле кольца по смещению из io_uring_params
+template <typename T>
+T* ringField(void* ring, unsigned offset) {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    
+    ringFd = ioUringSetup(entries, &params);
+    
+    if (ringFd < 0) {
+        throw systemError("io_uring недоступен", errno);
+    }
+    
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    
+    if (singleMap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        int error = errno;
+        close(ringFd);
+        throw systemError("Не удалось отобразить очередь io_uring", error);
+    }
+    
+    if (singleMap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            int error = errno;
+            munmap(sqRing, sqRingSize);
+            close(ringFd);
+            throw systemError("Не удалось отобразить очередь io_uring", error);
+        }
+    }
+    
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    
+    if (sqes == MAP_FAILED) {
+        sqes = nullptr;
+        int error = errno;
+        if (cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        munmap(sqRing, sqRingSize);
+        close(ringFd);
+        throw systemError("Не удалось отобразить очередь io_uring", error);
+    }
+    
+    sqHead = ringField<unsigned>(sqRing, params.sq_off.head);
+    sqTail = ringField<unsigned>(sqRing, params.sq_off.tail);
+    sqMask = ringField<unsigned>(sqRing, params.sq_off.ring_mask);
+    sqArray = ringField<unsigned>(sqRing, params.sq_off.array);
+    
+    cqHead = ringField<unsigned>(cqRing, params.cq_off.head);
+    cqTail = ringField<unsigned>(cqRing, params.cq_off.tail);
+    cqMask = ringField<unsigned>(cqRing, params.cq_off.ring_mask);
+    cqes = ringField<io_uring_cqe>(cqRing, params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+    munmap(sqes, sqesSize);
+    if (cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    munmap(sqRing, sqRingSize);
+    close(ringFd);
+}
+
+bool IoUring::available() {
+    static const bool supported = []() {
+        try {
+            IoUring probe(1);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }();
+    
+    return supported;
+}
+
+void IoUring::registerBuffers(const std::vector<Buffer>& buffers) {
+    std::vector<iovec> vectors(buffers.size());
+    
+    for (size_t i = 0; i < buffers.size(); i++) {
+        vectors[i].iov_base = buffers[i].data;
+        vectors[i].iov_len = buffers[i].size;
+    }
+    
+    if (ioUringRegister(ringFd, IORING_REGISTER_BUFFERS, vectors.data(), static_cast<unsigned>(vectors.size())) < 0) {
+        throw systemError("Не удалось зарегистрировать буферы io_uring", errno);
+    }
+}
+
+void IoUring::prepare(uint8_t opcode, int fd, const uint8_t* data, unsigned length,
+                      uint64_t offset, unsigned bufferIndex, uint64_t userData) {
+    unsigned tail = *sqTail;
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    
+    if (tail - head > *sqMask) {
+        throw std::logic_error("Очередь отправки io_uring заполнена");
+    }
+    
+    unsigned index = tail & *sqMask;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = length;
+    sqe->off = offset;
+    sqe->buf_index = static_cast<uint16_t>(bufferIndex);
+    sqe->user_data = userData;
+    
+    sqArray[index] = index;
+    
+    // Запись sqe видна ядру до нового значения хвоста
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    toSubmit++;
+}
+
+void IoUring::prepareRead(int fd, uint8_t* data, unsigned length, uint64_t offset, unsigned bufferIndex, uint64_t userData) {
+    prepare(IORING_OP_READ_FIXED, fd, data, length, offset, bufferIndex, userData);
+}
+
+void IoUring::prepareWrite(int fd, const uint8_t* data, unsigned length, uint64_t offset, unsigned bufferIndex, uint64_t userData) {
+    prepare(IORING_OP_WRITE_FIXED, fd, data, length, offset, bufferIndex, userData);
+}
+
+void IoUring::submit(unsigned minComplete) {
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    
+    while (true) {
+        int submitted = ioUringEnter(ringFd, toSubmit, minComplete, flags);
+        
+        if (submitted >= 0) {
+            toSubmit -= static_cast<unsigned>(submitted);
+            return;
+        }
+        
+        if (errno != EINTR) {
+            throw systemError("Ошибка io_uring_enter", errno);
+        }
+    }
+}
+
+bool IoUring::popCompletion(uint64_t& userData, int& result) {
+    unsigned head = *cqHead;
+    
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    
+    const io_uring_cqe* cqe = static_cast<io_uring_cqe*>(cqes) + (head & *cqMask);
+    userData = cqe->user_data;
+    result = cqe->res;
+    
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#else
+
+IoUring::IoUring(unsigned) {
+    throw std::runtime_error("io_uring недоступен на этой платформе");
+}
+
+IoUring::~IoUring() {
+}
+
+bool IoUring::available() {
+    return false;
+}
+
+void IoUring::registerBuffers(const std::vector<Buffer>&) {
+}
+
+void IoUring::prepareRead(int, uint8_t*, unsigned, uint64_t, unsigned, uint64_t) {
+}
+
+void IoUring::prepareWrite(int, const uint8_t*, unsigned, uint64_t, unsigned, uint64_t) {
+}
+
+void IoUring::submit(unsigned) {
+}
+
+bool IoUring::popCompletion(uint64_t&, int&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Асинхронный ввод-вывод Linux (io_uring) через системные вызовы, без liburing.
+// Поддержка проверяется во время выполнения: ядро может не поддерживать io_uring
+// или запрещать его (seccomp, sysctl)
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define RGR_IO_URING 1
+    #endif
+#endif
+
+class IoUring {
+public:
+    // Буфер для регистрации в ядре (операции READ_FIXED/WRITE_FIXED)
+    struct Buffer {
+        uint8_t* data;
+        size_t size;
+    };
+    
+    // Создание кольца на entries операций; при недоступности io_uring - исключение
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+    
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+    
+    // Поддерживает ли система io_uring (проверка выполняется один раз)
+    static bool available();
+    
+    // Регистрация буферов: ядро закрепляет страницы один раз вместо каждой операции
+    void registerBuffers(const std::vector<Buffer>& buffers);
+    
+    // Постановка чтения/записи в зарегистрированный буфер bufferIndex; userData возвращается в завершении
+    void prepareRead(int fd, uint8_t* data, unsigned length, uint64_t offset, unsigned bufferIndex, uint64_t userData);
+    void prepareWrite(int fd, const uint8_t* data, unsigned length, uint64_t offset, unsigned bufferIndex, uint64_t userData);
+    
+    // Отправка подготовленных операций и ожидание хотя бы minComplete завершений
+    void submit(unsigned minComplete);
+    
+    // Извлечение завершенной операции; result - число байт или -errno. false - завершений нет
+    bool popCompletion(uint64_t& userData, int& result);
+
+private:
+    void prepare(uint8_t opcode, int fd, const uint8_t* data, unsigned length,
+                 uint64_t offset, unsigned bufferIndex, uint64_t userData);
+    
+    int ringFd = -1;
+    
+    // Очередь отправки
+    void* sqRing = nullptr;
+    size_t sqRingSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    void* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned toSubmit = 0;
+    
+    // Очередь завершений (при IORING_FEAT_SINGLE_MMAP - то же отображение, что и sqRing)
+    void* cqRing = nullptr;
+    size_t cqRingSize = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    void* cqes = nullptr;
+};
+
+#endif
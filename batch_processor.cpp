@@ -0,0 +1,181 @@
+#include "../include/batch_processor.h"
+#include "../include/file_handler.h"
+#include "../include/stage_stats.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Файл в очереди обработки
+struct BatchEntry {
+    fs::path input;
+    fs::path output;
+    uint64_t size;
+};
+
+// Задача пула: один крупный файл или группа мелких
+struct BatchTask {
+    std::vector<size_t> entries;
+    uint64_t bytes = 0;
+};
+
+} // namespace
+
+BatchProcessor::BatchProcessor(ICipher& cipher, const std::string& key, bool encrypt)
+        : cipher(cipher), encrypt(encrypt) {
+    if (!cipher.validateKey(key)) {
+        throw std::invalid_argument("Неверный формат ключа для " + cipher.getName());
+    }
+    
+    StageStats::Timer timer(StageStats::KeySetup);
+    this->key = cipher.prepareKey(key);
+}
+
+uint64_t BatchProcessor::processFile(const std::string& inputPath, const std::string& outputPath, uint64_t size) {
+    // Потоковая обработка недоступна для AEAD: файл обрабатывается целиком
+    if (!cipher.supportsStreaming()) {
+        std::vector<uint8_t> data = FileHandler::readFile(inputPath);
+        std::vector<uint8_t> result;
+        {
+            StageStats::Timer timer(StageStats::Cipher, data.size());
+            result = encrypt ? cipher.encryptBytes(data, *key) : cipher.decryptBytes(data, *key);
+        }
+        
+        if (!FileHandler::writeFile(outputPath, result)) {
+            throw std::runtime_error("Ошибка при записи файла: " + outputPath);
+        }
+        
+        return result.size();
+    }
+    
+    std::unique_ptr<ICipherStream> stream = cipher.createStream();
+    stream->begin(*key, encrypt);
+    
+    // Крупный файл - через отображение в память: шифр делит его на фрагменты в общем пуле
+    if (size >= SMALL_FILE_LIMIT) {
+        return FileHandler::processMapped(inputPath, outputPath, *stream);
+    }
+    
+    std::vector<uint8_t> data = FileHandler::readFile(inputPath);
+    std::vector<uint8_t> result(stream->updateOutputSize(data.size()) + stream->finishOutputSize());
+    
+    size_t length;
+    {
+        StageStats::Timer timer(StageStats::Cipher, data.size());
+        length = stream->update(data.data(), data.size(), result.data());
+        length += stream->finish(result.data() + length);
+    }
+    result.resize(length);
+    
+    if (!FileHandler::writeFile(outputPath, result)) {
+        throw std::runtime_error("Ошибка при записи файла: " + outputPath);
+    }
+    
+    return result.size();
+}
+
+BatchProcessor::Stats BatchProcessor::run(const std::string& inputDir, const std::string& outputDir) {
+    fs::path inputRoot(inputDir);
+    fs::path outputRoot(outputDir);
+    
+    if (!fs::is_directory(inputRoot)) {
+        throw std::invalid_argument("Исходный каталог не существует: " + inputDir);
+    }
+    
+    fs::create_directories(outputRoot);
+    
+    if (fs::equivalent(inputRoot, outputRoot)) {
+        throw std::invalid_argument("Исходный и результирующий каталоги совпадают");
+    }
+    
+    // Список файлов собирается заранее, до записи результатов
+    std::vector<BatchEntry> entries;
+    
+    for (fs::recursive_directory_iterator it(inputRoot), end; it != end; ++it) {
+        const fs::directory_entry& item = *it;
+        
+        // Результирующий каталог внутри исходного дерева не обходится: иначе обход
+        // находил бы в нем созданные им же каталоги и не завершался
+        if (item.is_directory() && fs::equivalent(item.path(), outputRoot)) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        
+        fs::path relative = fs::relative(item.path(), inputRoot);
+        
+        if (item.is_directory()) {
+            fs::create_directories(outputRoot / relative);
+        } else if (item.is_regular_file()) {
+            entries.push_back({item.path(), outputRoot / relative, item.file_size()});
+        }
+    }
+    
+    // Крупные файлы - отдельные задачи, мелкие объединяются в группы до GROUP_BYTES
+    std::vector<BatchTask> tasks;
+    BatchTask group;
+    
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].size >= SMALL_FILE_LIMIT) {
+            BatchTask task;
+            task.entries.push_back(i);
+            task.bytes = entries[i].size;
+            tasks.push_back(task);
+            continue;
+        }
+        
+        group.entries.push_back(i);
+        group.bytes += entries[i].size;
+        
+        if (group.bytes >= GROUP_BYTES) {
+            tasks.push_back(group);
+            group = BatchTask();
+        }
+    }
+    
+    if (!group.entries.empty()) {
+        tasks.push_back(group);
+    }
+    
+    // Крупные задачи первыми: к концу остаются мелкие, и потоки загружены равномерно
+    std::sort(tasks.begin(), tasks.end(), [](const BatchTask& a, const BatchTask& b) {
+        return a.bytes > b.bytes;
+    });
+    
+    Stats stats;
+    std::atomic<size_t> failed{0};
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::mutex errorsMutex;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    ThreadPool::shared().parallelFor(tasks.size(), [&](size_t t) {
+        for (size_t index : tasks[t].entries) {
+            const BatchEntry& entry = entries[index];
+            
+            try {
+                bytesWritten += processFile(entry.input.string(), entry.output.string(), entry.size);
+                bytesRead += entry.size;
+            } catch (const std::exception& e) {
+                failed++;
+                std::lock_guard<std::mutex> lock(errorsMutex);
+                stats.errors.push_back(entry.input.string() + ": " + e.what());
+            }
+        }
+    });
+    
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.files = entries.size();
+    stats.failed = failed;
+    stats.bytesRead = bytesRead;
+    stats.bytesWritten = bytesWritten;
+    
+    return stats;
+}
@@ -0,0 +1,54 @@
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include "cipher_interface.h"
+#include <string>
+#include <vector>
+
+// Пакетная обработка дерева каталогов: структура исходного каталога повторяется
+// в результирующем, файлы обрабатываются одновременно в общем пуле потоков.
+// Мелкие файлы объединяются в группы, крупные дополнительно делятся на фрагменты самим шифром
+class BatchProcessor {
+public:
+    // Файлы меньше этого размера объединяются в группы
+    static const uint64_t SMALL_FILE_LIMIT = 1 << 20;
+    
+    // Суммарный объем группы мелких файлов
+    static const uint64_t GROUP_BYTES = 4 << 20;
+    
+    // Итоги обработки
+    struct Stats {
+        size_t files = 0;
+        size_t failed = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        double seconds = 0;
+        
+        // Ошибки по файлам: "путь: описание"
+        std::vector<std::string> errors;
+        
+        // Суммарная пропускная способность по входным данным, МиБ/с
+        double throughput() const {
+            return seconds > 0 ? bytesRead / seconds / (1024.0 * 1024.0) : 0;
+        }
+    };
+    
+    // cipher задает алгоритм и его настройки (режим, вариант); объект должен жить до конца run
+    BatchProcessor(ICipher& cipher, const std::string& key, bool encrypt);
+    
+    // Обработка всех обычных файлов inputDir с записью в outputDir под теми же относительными путями.
+    // Ошибка отдельного файла не прерывает обработку остальных
+    Stats run(const std::string& inputDir, const std::string& outputDir);
+
+private:
+    // Обработка одного файла, возвращает размер результата
+    uint64_t processFile(const std::string& inputPath, const std::string& outputPath, uint64_t size);
+    
+    ICipher& cipher;
+    
+    // Ключ подготавливается один раз и разделяется всеми задачами пула
+    PreparedKeyPtr key;
+    bool encrypt;
+};
+
+#endif
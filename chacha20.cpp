@@ -1,22 +1,47 @@
 #include "../include/chacha20.h"
+#include "../include/chacha20_simd.h"
+#include "../include/kernel_registry.h"
+#include "../include/poly1305.h"
+#include "../include/thread_pool.h"
+#include "../include/trace_log.h"
 #include <stdexcept>
 #include <cstring>
 #include <algorithm>
 
-uint32_t ChaCha20Cipher::rotl32(uint32_t value, int shift) {
+namespace {
+
+// Размер фрагмента AEAD: шифртекст фрагмента поступает в Poly1305, пока он в кэше
+const size_t AEAD_CHUNK = 16384;
+
+// Завершающий блок AEAD: длины AAD и шифртекста (little-endian, по 8 байт)
+void poly1305Lengths(Poly1305& poly, uint64_t aadLength, uint64_t cipherLength) {
+    uint8_t lengths[16];
+    
+    for (int i = 0; i < 8; i++) {
+        lengths[i] = static_cast<uint8_t>(aadLength >> (i * 8));
+        lengths[8 + i] = static_cast<uint8_t>(cipherLength >> (i * 8));
+    }
+    
+    poly.update(lengths, sizeof(lengths));
+}
+
+}
+
+uint32_t ChaCha20Cipher::rotl32(uint32_t value, int shift) const {
     return (value << shift) | (value >> (32 - shift));
 }
 
-void ChaCha20Cipher::quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+void ChaCha20Cipher::quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) const {
     a += b; d ^= a; d = rotl32(d, 16);
     c += d; b ^= c; b = rotl32(b, 12);
     a += b; d ^= a; d = rotl32(d, 8);
     c += d; b ^= c; b = rotl32(b, 7);
 }
 
-ChaCha20Cipher::ChaChaKey ChaCha20Cipher::parseKey(const std::string& key) {
-    if (key.length() != 88) {
-        throw std::invalid_argument("Ключ ChaCha20 должен содержать 88 hex символов");
+ChaCha20Cipher::ChaChaKey ChaCha20Cipher::parseKey(const std::string& key) const {
+    if (key.length() != static_cast<size_t>((KEY_SIZE + nonceSize()) * 2)) {
+        throw std::invalid_argument("Ключ ChaCha20 должен содержать " +
+                                    std::to_string((KEY_SIZE + nonceSize()) * 2) + " hex символов");
     }
     
     // Проверка на hex символы
@@ -27,6 +52,7 @@ ChaCha20Cipher::ChaChaKey ChaCha20Cipher::parseKey(const std::string& key) {
     }
     
     ChaChaKey result;
+    result.nonce.fill(0);
     
     // Парсинг ключа (64 hex символа = 32 байта)
     for (int i = 0; i < KEY_SIZE; i++) {
@@ -34,8 +60,8 @@ ChaCha20Cipher::ChaChaKey ChaCha20Cipher::parseKey(const std::string& key) {
         result.key[i] = static_cast<uint8_t>(std::stoul(byteStr, nullptr, 16));
     }
     
-    // Парсинг nonce (24 hex символа = 12 байт)
-    for (int i = 0; i < NONCE_SIZE; i++) {
+    // Парсинг nonce (12, 8 или 24 байта в зависимости от варианта)
+    for (int i = 0; i < nonceSize(); i++) {
         std::string byteStr = key.substr(64 + i * 2, 2);
         result.nonce[i] = static_cast<uint8_t>(std::stoul(byteStr, nullptr, 16));
     }
@@ -43,7 +69,63 @@ ChaCha20Cipher::ChaChaKey ChaCha20Cipher::parseKey(const std::string& key) {
     return result;
 }
 
-void ChaCha20Cipher::initState(std::array<uint32_t, STATE_SIZE>& state, const ChaChaKey& key, uint32_t counter) {
+int ChaCha20Cipher::nonceSize() const {
+    switch (variant) {
+        case Variant::Counter64:
+            return NONCE64_SIZE;
+        case Variant::XChaCha20:
+            return XNONCE_SIZE;
+        default:
+            return NONCE_SIZE;
+    }
+}
+
+void ChaCha20Cipher::hchacha20(const std::array<uint8_t, KEY_SIZE>& key, const uint8_t* nonce,
+                               std::array<uint8_t, KEY_SIZE>& subkey) const {
+    std::array<uint32_t, STATE_SIZE> x;
+    
+    x[0] = 0x61707865;
+    x[1] = 0x3320646e;
+    x[2] = 0x79622d32;
+    x[3] = 0x6b206574;
+    
+    for (int i = 0; i < 8; i++) {
+        x[4 + i] = static_cast<uint32_t>(key[i * 4]) |
+                   (static_cast<uint32_t>(key[i * 4 + 1]) << 8) |
+                   (static_cast<uint32_t>(key[i * 4 + 2]) << 16) |
+                   (static_cast<uint32_t>(key[i * 4 + 3]) << 24);
+    }
+    
+    for (int i = 0; i < 4; i++) {
+        x[12 + i] = static_cast<uint32_t>(nonce[i * 4]) |
+                    (static_cast<uint32_t>(nonce[i * 4 + 1]) << 8) |
+                    (static_cast<uint32_t>(nonce[i * 4 + 2]) << 16) |
+                    (static_cast<uint32_t>(nonce[i * 4 + 3]) << 24);
+    }
+    
+    // 20 раундов без добавления начального состояния
+    for (int i = 0; i < 10; i++) {
+        quarterRound(x[0], x[4], x[8], x[12]);
+        quarterRound(x[1], x[5], x[9], x[13]);
+        quarterRound(x[2], x[6], x[10], x[14]);
+        quarterRound(x[3], x[7], x[11], x[15]);
+        
+        quarterRound(x[0], x[5], x[10], x[15]);
+        quarterRound(x[1], x[6], x[11], x[12]);
+        quarterRound(x[2], x[7], x[8], x[13]);
+        quarterRound(x[3], x[4], x[9], x[14]);
+    }
+    
+    // Подключ - слова 0-3 и 12-15
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 4; b++) {
+            subkey[i * 4 + b] = static_cast<uint8_t>(x[i] >> (b * 8));
+            subkey[16 + i * 4 + b] = static_cast<uint8_t>(x[12 + i] >> (b * 8));
+        }
+    }
+}
+
+void ChaCha20Cipher::initState(std::array<uint32_t, STATE_SIZE>& state, const ChaChaKey& key, uint64_t counter) const {
     // Константы "expand 32-byte k" в little-endian формате
     // "expa" = 0x61707865
     // "nd 3" = 0x3320646e
@@ -54,32 +136,40 @@ void ChaCha20Cipher::initState(std::array<uint32_t, STATE_SIZE>& state, const Ch
     state[2] = 0x79622d32;
     state[3] = 0x6b206574;
     
+    // XChaCha20: ключ заменяется подключом, в состояние идут последние 8 байт nonce
+    std::array<uint8_t, KEY_SIZE> stateKey = key.key;
+    const uint8_t* nonce = key.nonce.data();
+    
+    if (variant == Variant::XChaCha20) {
+        hchacha20(key.key, key.nonce.data(), stateKey);
+        nonce = key.nonce.data() + 16;
+    }
+    
     // Ключ (little-endian)
     for (int i = 0; i < 8; i++) {
-        state[4 + i] = static_cast<uint32_t>(key.key[i * 4]) |
-                       (static_cast<uint32_t>(key.key[i * 4 + 1]) << 8) |
-                       (static_cast<uint32_t>(key.key[i * 4 + 2]) << 16) |
-                       (static_cast<uint32_t>(key.key[i * 4 + 3]) << 24);
+        state[4 + i] = static_cast<uint32_t>(stateKey[i * 4]) |
+                       (static_cast<uint32_t>(stateKey[i * 4 + 1]) << 8) |
+                       (static_cast<uint32_t>(stateKey[i * 4 + 2]) << 16) |
+                       (static_cast<uint32_t>(stateKey[i * 4 + 3]) << 24);
     }
     
-    // Счетчик блока
-    state[12] = counter;
+    // Счетчик блока: слово 12 или слова 12-13
+    state[12] = static_cast<uint32_t>(counter);
+    int nonceWord = 13;
     
-    // Nonce (little-endian)
-    state[13] = static_cast<uint32_t>(key.nonce[0]) |
-                (static_cast<uint32_t>(key.nonce[1]) << 8) |
-                (static_cast<uint32_t>(key.nonce[2]) << 16) |
-                (static_cast<uint32_t>(key.nonce[3]) << 24);
-    
-    state[14] = static_cast<uint32_t>(key.nonce[4]) |
-                (static_cast<uint32_t>(key.nonce[5]) << 8) |
-                (static_cast<uint32_t>(key.nonce[6]) << 16) |
-                (static_cast<uint32_t>(key.nonce[7]) << 24);
+    if (wideCounter()) {
+        state[13] = static_cast<uint32_t>(counter >> 32);
+        nonceWord = 14;
+    }
     
-    state[15] = static_cast<uint32_t>(key.nonce[8]) |
-                (static_cast<uint32_t>(key.nonce[9]) << 8) |
-                (static_cast<uint32_t>(key.nonce[10]) << 16) |
-                (static_cast<uint32_t>(key.nonce[11]) << 24);
+    // Nonce (little-endian) в оставшихся словах
+    for (int i = nonceWord; i < STATE_SIZE; i++) {
+        const uint8_t* p = nonce + (i - nonceWord) * 4;
+        state[i] = static_cast<uint32_t>(p[0]) |
+                   (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) |
+                   (static_cast<uint32_t>(p[3]) << 24);
+    }
 }
 
 void ChaCha20Cipher::chachaBlock(const std::array<uint32_t, STATE_SIZE>& input, std::array<uint32_t, STATE_SIZE>& output) {
@@ -106,26 +196,150 @@ void ChaCha20Cipher::chachaBlock(const std::array<uint32_t, STATE_SIZE>& input,
     }
 }
 
-void ChaCha20Cipher::processData(std::vector<uint8_t>& data, const ChaChaKey& key) {
-    std::array<uint32_t, STATE_SIZE> state;
+void ChaCha20Cipher::xorKeystream(const uint8_t* input, uint8_t* output, const uint8_t* keystream, size_t length) {
+    size_t i = 0;
+    
+    // Машинными словами; memcpy не требует выравнивания и сводится к обычной загрузке
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        uint64_t key;
+        std::memcpy(&word, input + i, 8);
+        std::memcpy(&key, keystream + i, 8);
+        word ^= key;
+        std::memcpy(output + i, &word, 8);
+    }
+    
+    // Хвост
+    for (; i < length; i++) {
+        output[i] = input[i] ^ keystream[i];
+    }
+}
+
+void ChaCha20Cipher::processData(const uint8_t* input, uint8_t* output, size_t length,
+                                 const std::array<uint32_t, STATE_SIZE>& stateTemplate, uint64_t offset) {
+    if (length == 0) {
+        return;
+    }
+    
+    std::array<uint32_t, STATE_SIZE> state = stateTemplate;
     std::array<uint32_t, STATE_SIZE> keystream;
     
-    size_t blockCount = (data.size() + 63) / 64;
+    uint64_t counter = stateTemplate[12];
+    if (wideCounter()) {
+        counter |= static_cast<uint64_t>(stateTemplate[13]) << 32;
+    }
+    counter += offset / 64;
+    
+    // 32-битный счетчик не должен повторяться: иначе повторится и keystream
+    if (!wideCounter()) {
+        uint64_t lastBlock = counter + (offset % 64 + length - 1) / 64;
+        if (lastBlock > 0xFFFFFFFFULL) {
+            throw std::length_error("Превышен объем данных для 32-битного счетчика ChaCha20 (256 ГиБ); "
+                                    "используйте 64-битный счетчик или XChaCha20");
+        }
+    }
+    
+    // Большой объем делится на фрагменты для общего пула потоков:
+    // keystream фрагмента определяется только его смещением в потоке
+    if (length > PARALLEL_CHUNK && ThreadPool::shared().size() > 1) {
+        ThreadPool::shared().parallelRange(length, PARALLEL_CHUNK, [&](size_t begin, size_t end) {
+            processData(input + begin, output + begin, end - begin, stateTemplate, offset + begin);
+        });
+        return;
+    }
+    
+    // Байты первого блока до offset пропускаются
+    size_t skip = static_cast<size_t>(offset % 64);
+    
+    // Буфер на максимальную ширину векторного ядра
+    uint8_t buffer[ChaCha20Simd::AVX512_BLOCKS * 64];
+    const int kernel = KernelRegistry::selected(KernelRegistry::ChaCha20);
+    TraceLog::Span span("chacha20", "kernel", length, KernelRegistry::kernels(KernelRegistry::ChaCha20)[kernel].name);
+    const int width = ChaCha20Simd::blocksPerCall(kernel);
+    
+    for (size_t pos = 0; pos < length; ) {
+        state[12] = static_cast<uint32_t>(counter);
+        if (wideCounter()) {
+            state[13] = static_cast<uint32_t>(counter >> 32);
+        }
+        
+        // Векторное ядро считает счетчики только в слове 12: пакет, в котором
+        // 64-битный счетчик переходит через 2^32, обрабатывается скалярно
+        bool carryInBatch = wideCounter() && width > 0 &&
+                            static_cast<uint32_t>(counter) > 0xFFFFFFFFu - static_cast<uint32_t>(width - 1);
+        size_t generated;
+        
+        if (width > 0 && !carryInBatch) {
+            // Векторное ядро: несколько последовательных блоков за вызов
+            ChaCha20Simd::keystream(kernel, state.data(), buffer);
+            generated = static_cast<size_t>(width);
+        } else {
+            // Эталонная скалярная реализация
+            chachaBlock(state, keystream);
+            for (int i = 0; i < 64; i++) {
+                buffer[i] = (keystream[i / 4] >> ((i % 4) * 8)) & 0xFF;
+            }
+            generated = 1;
+        }
+        
+        size_t chunk = std::min(generated * 64 - skip, length - pos);
+        xorKeystream(input + pos, output + pos, buffer + skip, chunk);
+        skip = 0;
+        
+        counter += generated;
+        pos += chunk;
+    }
+}
+
+bool ChaCha20Cipher::verifyKernel(int kernel) {
+    // Скалярное ядро - это сам chachaBlock
+    if (kernel == ChaCha20Simd::Scalar) {
+        return true;
+    }
+    
+    ChaCha20Cipher reference;
+    const int width = ChaCha20Simd::blocksPerCall(kernel);
+    
+    // Счетчик выбран так, чтобы слово 12 переходило через 2^32 внутри вызова ядра
+    std::array<uint32_t, STATE_SIZE> state;
+    for (int i = 0; i < STATE_SIZE; i++) {
+        state[i] = 0x9E3779B9u * static_cast<uint32_t>(i + 1);
+    }
+    state[12] = 0xFFFFFFFFu - static_cast<uint32_t>(width / 2);
+    
+    uint8_t buffer[ChaCha20Simd::AVX512_BLOCKS * 64];
+    ChaCha20Simd::keystream(kernel, state.data(), buffer);
+    
+    std::array<uint32_t, STATE_SIZE> input = state;
+    std::array<uint32_t, STATE_SIZE> expected;
     
-    for (size_t block = 0; block < blockCount; block++) {
-        initState(state, key, static_cast<uint32_t>(block));
-        chachaBlock(state, keystream);
+    for (int block = 0; block < width; block++) {
+        input[12] = state[12] + static_cast<uint32_t>(block);
+        reference.chachaBlock(input, expected);
         
-        // XOR данных с keystream
-        for (size_t i = 0; i < 64 && (block * 64 + i) < data.size(); i++) {
-            uint8_t keystreamByte = (keystream[i / 4] >> ((i % 4) * 8)) & 0xFF;
-            data[block * 64 + i] ^= keystreamByte;
+        for (int i = 0; i < 64; i++) {
+            if (buffer[block * 64 + i] != ((expected[i / 4] >> ((i % 4) * 8)) & 0xFF)) {
+                return false;
+            }
         }
     }
+    
+    return width > 0;
+}
+
+std::string ChaCha20Cipher::getKeyFormat() const {
+    switch (variant) {
+        case Variant::Counter64:
+            return "80 hex символов: 64 для ключа + 16 для nonce";
+        case Variant::XChaCha20:
+            return "112 hex символов: 64 для ключа + 48 для nonce";
+        default:
+            return "88 hex символов: 64 для ключа + 24 для nonce";
+    }
 }
 
 bool ChaCha20Cipher::validateKey(const std::string& key) const {
-    if (key.length() != 88) return false;
+    if (key.length() != static_cast<size_t>((KEY_SIZE + nonceSize()) * 2)) return false;
     
     for (char c : key) {
         if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
@@ -134,31 +348,271 @@ bool ChaCha20Cipher::validateKey(const std::string& key) const {
     return true;
 }
 
-std::vector<uint8_t> ChaCha20Cipher::encryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
+void ChaCha20Cipher::poly1305Key(const std::array<uint32_t, STATE_SIZE>& state, uint8_t* polyKey) {
+    uint8_t zero[Poly1305::KEY_SIZE] = {0};
+    processData(zero, polyKey, Poly1305::KEY_SIZE, state, 0);
+}
+
+size_t ChaCha20Cipher::sealAead(const uint8_t* input, size_t length, uint8_t* output,
+                                const std::array<uint32_t, STATE_SIZE>& state) {
+    uint8_t polyKey[Poly1305::KEY_SIZE];
+    poly1305Key(state, polyKey);
+    
+    Poly1305 poly(polyKey);
+    poly.update(associatedData.data(), associatedData.size());
+    poly.padToBlock();
+    
+    // Шифрование начинается со счетчика 1 (смещение 64 байта в потоке)
+    for (size_t offset = 0; offset < length; offset += AEAD_CHUNK) {
+        size_t chunk = std::min(AEAD_CHUNK, length - offset);
+        processData(input + offset, output + offset, chunk, state, 64 + offset);
+        poly.update(output + offset, chunk);
+    }
+    
+    poly.padToBlock();
+    poly1305Lengths(poly, associatedData.size(), length);
+    poly.finish(output + length);
+    
+    return length + TAG_SIZE;
+}
+
+size_t ChaCha20Cipher::openAead(const uint8_t* input, size_t length, uint8_t* output,
+                                const std::array<uint32_t, STATE_SIZE>& state) {
+    if (length < static_cast<size_t>(TAG_SIZE)) {
+        throw std::invalid_argument("Данные короче тега Poly1305");
+    }
+    
+    size_t cipherSize = length - TAG_SIZE;
+    
+    uint8_t polyKey[Poly1305::KEY_SIZE];
+    poly1305Key(state, polyKey);
+    
+    Poly1305 poly(polyKey);
+    poly.update(associatedData.data(), associatedData.size());
+    poly.padToBlock();
+    
+    // Фрагмент сначала аутентифицируется, затем расшифровывается (в том числе на месте)
+    for (size_t offset = 0; offset < cipherSize; offset += AEAD_CHUNK) {
+        size_t chunk = std::min(AEAD_CHUNK, cipherSize - offset);
+        poly.update(input + offset, chunk);
+        processData(input + offset, output + offset, chunk, state, 64 + offset);
+    }
+    
+    poly.padToBlock();
+    poly1305Lengths(poly, associatedData.size(), cipherSize);
+    
+    uint8_t tag[TAG_SIZE];
+    poly.finish(tag);
+    
+    // Сравнение без раннего выхода; тег за шифртекстом не перезаписывается и при output == input
+    uint8_t diff = 0;
+    for (int i = 0; i < TAG_SIZE; i++) {
+        diff |= tag[i] ^ input[cipherSize + i];
+    }
+    
+    if (diff != 0) {
+        std::fill(output, output + cipherSize, 0);
+        throw std::runtime_error("Тег Poly1305 не совпадает: данные повреждены или ключ неверен");
+    }
+    
+    return cipherSize;
+}
+
+PreparedKeyPtr ChaCha20Cipher::prepareKey(const std::string& key) const {
     if (!validateKey(key)) {
         throw std::invalid_argument("Неверный формат ключа для ChaCha20");
     }
     
-    ChaChaKey chachaKey = parseKey(key);
-    std::vector<uint8_t> result = data;
-    processData(result, chachaKey);
+    // Шаблон состояния (для XChaCha20 - уже с подключом HChaCha20) строится один раз
+    auto prepared = std::make_shared<Key>();
+    prepared->variant = variant;
+    initState(prepared->state, parseKey(key), 0);
+    
+    return prepared;
+}
+
+const ChaCha20Cipher::Key& ChaCha20Cipher::preparedKey(const PreparedKey& key) const {
+    const Key* prepared = dynamic_cast<const Key*>(&key);
+    
+    if (!prepared) {
+        throw std::invalid_argument("Ключ подготовлен не для алгоритма ChaCha20");
+    }
+    
+    if (prepared->variant != variant) {
+        throw std::invalid_argument("Ключ ChaCha20 подготовлен для другого варианта счетчика");
+    }
     
+    return *prepared;
+}
+
+std::vector<uint8_t> ChaCha20Cipher::encryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
+    return encryptBytes(data, *prepareKey(key));
+}
+
+std::vector<uint8_t> ChaCha20Cipher::encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) {
+    std::vector<uint8_t> result(encryptedSize(data.size()));
+    encryptBytes(data.data(), data.size(), result.data(), key);
     return result;
 }
 
+size_t ChaCha20Cipher::encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) {
+    const Key& prepared = preparedKey(key);
+    
+    if (mode == Mode::Poly1305) {
+        return sealAead(input, length, output, prepared.state);
+    }
+    
+    processData(input, output, length, prepared.state, 0);
+    return length;
+}
+
+void ChaCha20Cipher::encryptInPlace(std::vector<uint8_t>& data, const std::string& key) {
+    if (mode == Mode::Poly1305) {
+        throw std::logic_error("Операция недоступна в режиме ChaCha20-Poly1305");
+    }
+    
+    encryptInPlace(data, *prepareKey(key));
+}
+
+void ChaCha20Cipher::encryptInPlace(std::vector<uint8_t>& data, const PreparedKey& key) {
+    if (mode == Mode::Poly1305) {
+        throw std::logic_error("Операция недоступна в режиме ChaCha20-Poly1305");
+    }
+    
+    processData(data.data(), data.data(), data.size(), preparedKey(key).state, 0);
+}
+
+void ChaCha20Cipher::decryptInPlace(std::vector<uint8_t>& data, const std::string& key) {
+    encryptInPlace(data, key);
+}
+
+void ChaCha20Cipher::decryptInPlace(std::vector<uint8_t>& data, const PreparedKey& key) {
+    encryptInPlace(data, key);
+}
+
 std::vector<uint8_t> ChaCha20Cipher::decryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
+    return decryptBytes(data, *prepareKey(key));
+}
+
+std::vector<uint8_t> ChaCha20Cipher::decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) {
+    std::vector<uint8_t> result(decryptedSize(data.size()));
+    decryptBytes(data.data(), data.size(), result.data(), key);
+    return result;
+}
+
+size_t ChaCha20Cipher::decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) {
+    if (mode == Mode::Poly1305) {
+        return openAead(input, length, output, preparedKey(key).state);
+    }
+    
     // ChaCha20 симметричен - шифрование = дешифрование
-    return encryptBytes(data, key);
+    return encryptBytes(input, length, output, key);
+}
+
+size_t ChaCha20Cipher::encryptedSize(size_t length) const {
+    return mode == Mode::Poly1305 ? length + TAG_SIZE : length;
+}
+
+size_t ChaCha20Cipher::decryptedSize(size_t length) const {
+    if (mode == Mode::Poly1305) {
+        return length < static_cast<size_t>(TAG_SIZE) ? 0 : length - TAG_SIZE;
+    }
+    
+    return length;
+}
+
+std::vector<uint8_t> ChaCha20Cipher::cryptAt(const std::vector<uint8_t>& data, const std::string& key, uint64_t offset) {
+    if (mode == Mode::Poly1305) {
+        throw std::logic_error("Операция недоступна в режиме ChaCha20-Poly1305");
+    }
+    
+    return cryptAt(data, *prepareKey(key), offset);
+}
+
+std::vector<uint8_t> ChaCha20Cipher::cryptAt(const std::vector<uint8_t>& data, const PreparedKey& key, uint64_t offset) {
+    if (mode == Mode::Poly1305) {
+        throw std::logic_error("Операция недоступна в режиме ChaCha20-Poly1305");
+    }
+    
+    std::vector<uint8_t> result(data.size());
+    processData(data.data(), result.data(), data.size(), preparedKey(key).state, offset);
+    
+    return result;
+}
+
+// Потоковый контекст ChaCha20: между вызовами переносится только смещение в потоке.
+// AEAD не поддерживается: открытый текст нельзя выдавать до проверки тега
+class ChaCha20Cipher::Stream : public ICipherStream {
+public:
+    explicit Stream(const ChaCha20Cipher& settings) : cipher(settings) {}
+    
+    void begin(const std::string& key, bool encrypt) override {
+        if (cipher.mode == Mode::Poly1305) {
+            throw std::logic_error("Потоковая обработка недоступна в режиме ChaCha20-Poly1305");
+        }
+        
+        begin(*cipher.prepareKey(key), encrypt);
+    }
+    
+    void begin(const PreparedKey& key, bool) override {
+        if (cipher.mode == Mode::Poly1305) {
+            throw std::logic_error("Потоковая обработка недоступна в режиме ChaCha20-Poly1305");
+        }
+        
+        state = cipher.preparedKey(key).state;
+        offset = 0;
+        started = true;
+    }
+    
+    size_t update(const uint8_t* input, size_t length, uint8_t* output) override {
+        if (!started) {
+            throw std::logic_error("Поток не инициализирован: требуется begin");
+        }
+        
+        cipher.processData(input, output, length, state, offset);
+        offset += length;
+        return length;
+    }
+    
+    size_t finish(uint8_t*) override {
+        if (!started) {
+            throw std::logic_error("Поток не инициализирован: требуется begin");
+        }
+        
+        started = false;
+        return 0;
+    }
+    
+    size_t updateOutputSize(size_t length) const override { return length; }
+    size_t finishOutputSize() const override { return 0; }
+
+private:
+    ChaCha20Cipher cipher;
+    std::array<uint32_t, STATE_SIZE> state{};
+    uint64_t offset = 0;
+    bool started = false;
+};
+
+std::unique_ptr<ICipherStream> ChaCha20Cipher::createStream() const {
+    return std::make_unique<Stream>(*this);
 }
 
 std::string ChaCha20Cipher::encrypt(const std::string& plaintext, const std::string& key) {
+    return encrypt(plaintext, *prepareKey(key));
+}
+
+std::string ChaCha20Cipher::encrypt(const std::string& plaintext, const PreparedKey& key) {
     std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
     std::vector<uint8_t> encrypted = encryptBytes(data, key);
-    return std::string(encrypted.begin(), encrypted.end());
+    return TextCodec::encode(encrypted, textEncoding);
 }
 
 std::string ChaCha20Cipher::decrypt(const std::string& ciphertext, const std::string& key) {
-    std::vector<uint8_t> data(ciphertext.begin(), ciphertext.end());
+    return decrypt(ciphertext, *prepareKey(key));
+}
+
+std::string ChaCha20Cipher::decrypt(const std::string& ciphertext, const PreparedKey& key) {
+    std::vector<uint8_t> data = TextCodec::decode(ciphertext, textEncoding);
     std::vector<uint8_t> decrypted = decryptBytes(data, key);
     return std::string(decrypted.begin(), decrypted.end());
 }
\ No newline at end of file
@@ -6,6 +6,20 @@
 
 // Реализация алгоритма ChaCha20
 class ChaCha20Cipher : public ICipher {
+public:
+    // Режим работы
+    enum class Mode {
+        Stream,     // чистый поток ChaCha20, счетчик с 0
+        Poly1305    // AEAD ChaCha20-Poly1305 (RFC 8439): шифртекст + 16 байт тега
+    };
+    
+    // Вариант раскладки счетчика и nonce
+    enum class Variant {
+        IETF,       // RFC 8439: 32-битный счетчик (до 256 ГиБ), nonce 12 байт
+        Counter64,  // 64-битный счетчик (слова 12-13), nonce 8 байт
+        XChaCha20   // подключ HChaCha20, nonce 24 байта, 64-битный счетчик
+    };
+
 private:
     // Размер блока состояния
     static const int STATE_SIZE = 16;
@@ -13,41 +27,136 @@ private:
     // Размер ключа в байтах
     static const int KEY_SIZE = 32;
     
-    // Размер nonce в байтах
+    // Размер nonce в байтах для вариантов IETF, Counter64 и XChaCha20
     static const int NONCE_SIZE = 12;
+    static const int NONCE64_SIZE = 8;
+    static const int XNONCE_SIZE = 24;
+    
+    // Размер тега Poly1305 в байтах
+    static const int TAG_SIZE = 16;
+    
+    // Размер фрагмента параллельной обработки (в пределах кэша L2)
+    static const size_t PARALLEL_CHUNK = 256 * 1024;
     
-    // Структура ключа: ключ + nonce
+    // Текущий режим и ассоциированные данные для AEAD
+    Mode mode = Mode::Stream;
+    std::vector<uint8_t> associatedData;
+    
+    // Текущий вариант счетчика
+    Variant variant = Variant::IETF;
+    
+    // Представление шифртекста в текстовом режиме (по умолчанию - байты как есть)
+    TextEncoding textEncoding = TextEncoding::Raw;
+    
+    // Структура ключа: ключ + nonce (используется nonceSize() первых байт)
     struct ChaChaKey {
         std::array<uint8_t, KEY_SIZE> key;
-        std::array<uint8_t, NONCE_SIZE> nonce;
+        std::array<uint8_t, XNONCE_SIZE> nonce;
     };
     
+    // Подготовленный ключ: шаблон состояния с нулевым счетчиком для варианта, в котором ключ подготовлен
+    struct Key : PreparedKey {
+        Variant variant;
+        std::array<uint32_t, STATE_SIZE> state;
+    };
+    
+    // Проверка, что ключ подготовлен ChaCha20 для текущего варианта
+    const Key& preparedKey(const PreparedKey& key) const;
+    
     // Парсинг ключа из hex-строки
-    ChaChaKey parseKey(const std::string& key);
+    ChaChaKey parseKey(const std::string& key) const;
+    
+    // Длина nonce для текущего варианта
+    int nonceSize() const;
     
-    // Инициализация состояния
-    void initState(std::array<uint32_t, STATE_SIZE>& state, const ChaChaKey& key, uint32_t counter);
+    // 64-битный счетчик в словах 12-13
+    bool wideCounter() const { return variant != Variant::IETF; }
+    
+    // Инициализация состояния (для XChaCha20 ключ заменяется подключом HChaCha20)
+    void initState(std::array<uint32_t, STATE_SIZE>& state, const ChaChaKey& key, uint64_t counter) const;
+    
+    // HChaCha20: подключ из ключа и первых 16 байт nonce
+    void hchacha20(const std::array<uint8_t, KEY_SIZE>& key, const uint8_t* nonce, std::array<uint8_t, KEY_SIZE>& subkey) const;
     
     // Quarter round функция
-    void quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d);
+    void quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) const;
     
     // Циклический сдвиг влево
-    uint32_t rotl32(uint32_t value, int shift);
+    uint32_t rotl32(uint32_t value, int shift) const;
     
     // Генерация блока keystream
     void chachaBlock(const std::array<uint32_t, STATE_SIZE>& input, std::array<uint32_t, STATE_SIZE>& output);
     
-    // XOR данных с keystream
-    void processData(std::vector<uint8_t>& data, const ChaChaKey& key);
+    // XOR данных с keystream: шаблон состояния строится один раз на ключ,
+    // для каждого блока меняется только слово счетчика. Допускается input == output.
+    // offset - позиция данных в потоке: счетчик = offset / 64, сдвиг внутри блока = offset % 64
+    void processData(const uint8_t* input, uint8_t* output, size_t length,
+                     const std::array<uint32_t, STATE_SIZE>& stateTemplate, uint64_t offset);
+    
+    // XOR словами по 8 байт с побайтовым хвостом (невыровненные адреса допустимы)
+    static void xorKeystream(const uint8_t* input, uint8_t* output, const uint8_t* keystream, size_t length);
+
+    // AEAD: шифрование с выработкой тега по ассоциированным данным и шифртексту.
+    // output вмещает length + TAG_SIZE байт, возвращается размер результата
+    size_t sealAead(const uint8_t* input, size_t length, uint8_t* output, const std::array<uint32_t, STATE_SIZE>& state);
+    
+    // AEAD: дешифрование с проверкой тега; при несовпадении тега output обнуляется и выбрасывается исключение
+    size_t openAead(const uint8_t* input, size_t length, uint8_t* output, const std::array<uint32_t, STATE_SIZE>& state);
+    
+    // Блок 0 дает одноразовый ключ Poly1305
+    void poly1305Key(const std::array<uint32_t, STATE_SIZE>& state, uint8_t* polyKey);
+    
+    // Потоковый контекст (определен в chacha20.cpp)
+    class Stream;
 
 public:
     std::string encrypt(const std::string& plaintext, const std::string& key) override;
     std::string decrypt(const std::string& ciphertext, const std::string& key) override;
     std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const std::string& key) override;
     std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const std::string& key) override;
+    PreparedKeyPtr prepareKey(const std::string& key) const override;
+    std::string encrypt(const std::string& plaintext, const PreparedKey& key) override;
+    std::string decrypt(const std::string& ciphertext, const PreparedKey& key) override;
+    std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) override;
+    std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) override;
+    size_t encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) override;
+    size_t decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) override;
+    size_t encryptedSize(size_t length) const override;
+    size_t decryptedSize(size_t length) const override;
     std::string getName() const override { return "ChaCha20"; }
-    std::string getKeyFormat() const override { return "88 hex символов: 64 для ключа + 24 для nonce"; }
+    std::string getKeyFormat() const override;
     bool validateKey(const std::string& key) const override;
+    std::unique_ptr<ICipherStream> createStream() const override;
+    bool supportsStreaming() const override { return mode != Mode::Poly1305; }
+    void setTextEncoding(TextEncoding encoding) override { textEncoding = encoding; }
+    TextEncoding getTextEncoding() const override { return textEncoding; }
+    
+    // Выбор режима работы
+    void setMode(Mode newMode) { mode = newMode; }
+    Mode getMode() const { return mode; }
+    
+    // Выбор варианта счетчика
+    void setVariant(Variant newVariant) { variant = newVariant; }
+    Variant getVariant() const { return variant; }
+    
+    // Ассоциированные данные (аутентифицируются, но не шифруются) для режима Poly1305
+    void setAssociatedData(const std::vector<uint8_t>& aad) { associatedData = aad; }
+    
+    // Шифрование на месте без копирования входных данных
+    void encryptInPlace(std::vector<uint8_t>& data, const std::string& key);
+    void encryptInPlace(std::vector<uint8_t>& data, const PreparedKey& key);
+    
+    // Дешифрование на месте (совпадает с шифрованием)
+    void decryptInPlace(std::vector<uint8_t>& data, const std::string& key);
+    void decryptInPlace(std::vector<uint8_t>& data, const PreparedKey& key);
+    
+    // Шифрование/дешифрование фрагмента, начинающегося с позиции offset исходного потока
+    std::vector<uint8_t> cryptAt(const std::vector<uint8_t>& data, const std::string& key, uint64_t offset);
+    std::vector<uint8_t> cryptAt(const std::vector<uint8_t>& data, const PreparedKey& key, uint64_t offset);
+    
+    // Самопроверка ядра ChaCha20Simd::Kernel (для KernelRegistry): блоки keystream,
+    // в том числе при переходе счетчика через 2^32, должны совпасть с chachaBlock
+    static bool verifyKernel(int kernel);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "../include/chacha20_simd.h"
+#include "../include/cpu_features.h"
+
+#ifdef RGR_X86_SIMD
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+#ifdef RGR_X86_SIMD
+
+__attribute__((target("sse2")))
+inline __m128i rotlSse2(__m128i value, int shift) {
+    return _mm_or_si128(_mm_slli_epi32(value, shift), _mm_srli_epi32(value, 32 - shift));
+}
+
+__attribute__((target("sse2")))
+inline void quarterRoundSse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = rotlSse2(d, 16);
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = rotlSse2(b, 12);
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = rotlSse2(d, 8);
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = rotlSse2(b, 7);
+}
+
+// Транспонирование 4x4: слова [w, w+3] четырех блоков -> 16 байт каждого блока
+__attribute__((target("sse2")))
+inline void storeGroupSse2(__m128i a, __m128i b, __m128i c, __m128i d, uint8_t* output) {
+    __m128i t0 = _mm_unpacklo_epi32(a, b);
+    __m128i t1 = _mm_unpacklo_epi32(c, d);
+    __m128i t2 = _mm_unpackhi_epi32(a, b);
+    __m128i t3 = _mm_unpackhi_epi32(c, d);
+    
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 64), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 128), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 192), _mm_unpackhi_epi64(t2, t3));
+}
+
+__attribute__((target("avx2")))
+inline __m256i rotlAvx2(__m256i value, int shift) {
+    return _mm256_or_si256(_mm256_slli_epi32(value, shift), _mm256_srli_epi32(value, 32 - shift));
+}
+
+__attribute__((target("avx2")))
+inline void quarterRoundAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d, __m256i rot16, __m256i rot8) {
+    // Сдвиги на 16 и 8 бит кратны байту и выполняются перестановкой байтов
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot16);
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = rotlAvx2(b, 12);
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot8);
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = rotlAvx2(b, 7);
+}
+
+// Транспонирование 4x4 внутри 128-битных половин: результат r[k] содержит
+// слова группы для блока k (младшая половина) и блока k + 4 (старшая)
+__attribute__((target("avx2")))
+inline void transposeAvx2(__m256i a, __m256i b, __m256i c, __m256i d, __m256i* r) {
+    __m256i t0 = _mm256_unpacklo_epi32(a, b);
+    __m256i t1 = _mm256_unpacklo_epi32(c, d);
+    __m256i t2 = _mm256_unpackhi_epi32(a, b);
+    __m256i t3 = _mm256_unpackhi_epi32(c, d);
+    
+    r[0] = _mm256_unpacklo_epi64(t0, t1);
+    r[1] = _mm256_unpackhi_epi64(t0, t1);
+    r[2] = _mm256_unpacklo_epi64(t2, t3);
+    r[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+__attribute__((target("avx512f")))
+inline void quarterRoundAvx512(__m512i& a, __m512i& b, __m512i& c, __m512i& d) {
+    a = _mm512_add_epi32(a, b); d = _mm512_xor_si512(d, a); d = _mm512_rol_epi32(d, 16);
+    c = _mm512_add_epi32(c, d); b = _mm512_xor_si512(b, c); b = _mm512_rol_epi32(b, 12);
+    a = _mm512_add_epi32(a, b); d = _mm512_xor_si512(d, a); d = _mm512_rol_epi32(d, 8);
+    c = _mm512_add_epi32(c, d); b = _mm512_xor_si512(b, c); b = _mm512_rol_epi32(b, 7);
+}
+
+__attribute__((target("avx512f")))
+inline void transposeAvx512(__m512i a, __m512i b, __m512i c, __m512i d, __m512i* r) {
+    __m512i t0 = _mm512_unpacklo_epi32(a, b);
+    __m512i t1 = _mm512_unpacklo_epi32(c, d);
+    __m512i t2 = _mm512_unpackhi_epi32(a, b);
+    __m512i t3 = _mm512_unpackhi_epi32(c, d);
+    
+    r[0] = _mm512_unpacklo_epi64(t0, t1);
+    r[1] = _mm512_unpackhi_epi64(t0, t1);
+    r[2] = _mm512_unpacklo_epi64(t2, t3);
+    r[3] = _mm512_unpackhi_epi64(t2, t3);
+}
+
+#endif
+
+}
+
+int ChaCha20Simd::blocksPerCall(int kernel) {
+    switch (kernel) {
+        case Avx512:
+            return AVX512_BLOCKS;
+        case Avx2:
+            return AVX2_BLOCKS;
+        case Sse2:
+            return SSE2_BLOCKS;
+        default:
+            return 0;
+    }
+}
+
+void ChaCha20Simd::keystream(int kernel, const uint32_t* state, uint8_t* output) {
+    switch (kernel) {
+        case Avx512:
+            keystreamAvx512(state, output);
+            break;
+        case Avx2:
+            keystreamAvx2(state, output);
+            break;
+        case Sse2:
+            keystreamSse2(state, output);
+            break;
+        default:
+            break;
+    }
+}
+
+#ifdef RGR_X86_SIMD
+
+__attribute__((target("sse2")))
+void ChaCha20Simd::keystreamSse2(const uint32_t* state, uint8_t* output) {
+    __m128i x[16];
+    __m128i initial[16];
+    
+    for (int i = 0; i < 16; i++) {
+        initial[i] = _mm_set1_epi32(static_cast<int>(state[i]));
+    }
+    // Счетчики блоков в полосах: state[12] + 0..3 (по модулю 2^32)
+    initial[12] = _mm_add_epi32(initial[12], _mm_setr_epi32(0, 1, 2, 3));
+    
+    for (int i = 0; i < 16; i++) {
+        x[i] = initial[i];
+    }
+    
+    // 20 раундов (10 двойных раундов)
+    for (int i = 0; i < 10; i++) {
+        quarterRoundSse2(x[0], x[4], x[8], x[12]);
+        quarterRoundSse2(x[1], x[5], x[9], x[13]);
+        quarterRoundSse2(x[2], x[6], x[10], x[14]);
+        quarterRoundSse2(x[3], x[7], x[11], x[15]);
+        
+        quarterRoundSse2(x[0], x[5], x[10], x[15]);
+        quarterRoundSse2(x[1], x[6], x[11], x[12]);
+        quarterRoundSse2(x[2], x[7], x[8], x[13]);
+        quarterRoundSse2(x[3], x[4], x[9], x[14]);
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm_add_epi32(x[i], initial[i]);
+    }
+    
+    for (int g = 0; g < 4; g++) {
+        storeGroupSse2(x[4 * g], x[4 * g + 1], x[4 * g + 2], x[4 * g + 3], output + 16 * g);
+    }
+}
+
+__attribute__((target("avx2")))
+void ChaCha20Simd::keystreamAvx2(const uint32_t* state, uint8_t* output) {
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                          3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    __m256i x[16];
+    __m256i initial[16];
+    
+    for (int i = 0; i < 16; i++) {
+        initial[i] = _mm256_set1_epi32(static_cast<int>(state[i]));
+    }
+    initial[12] = _mm256_add_epi32(initial[12], _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    
+    for (int i = 0; i < 16; i++) {
+        x[i] = initial[i];
+    }
+    
+    for (int i = 0; i < 10; i++) {
+        quarterRoundAvx2(x[0], x[4], x[8], x[12], rot16, rot8);
+        quarterRoundAvx2(x[1], x[5], x[9], x[13], rot16, rot8);
+        quarterRoundAvx2(x[2], x[6], x[10], x[14], rot16, rot8);
+        quarterRoundAvx2(x[3], x[7], x[11], x[15], rot16, rot8);
+        
+        quarterRoundAvx2(x[0], x[5], x[10], x[15], rot16, rot8);
+        quarterRoundAvx2(x[1], x[6], x[11], x[12], rot16, rot8);
+        quarterRoundAvx2(x[2], x[7], x[8], x[13], rot16, rot8);
+        quarterRoundAvx2(x[3], x[4], x[9], x[14], rot16, rot8);
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm256_add_epi32(x[i], initial[i]);
+    }
+    
+    // r[g][k]: слова 4g..4g+3 блоков k и k + 4
+    __m256i r[4][4];
+    for (int g = 0; g < 4; g++) {
+        transposeAvx2(x[4 * g], x[4 * g + 1], x[4 * g + 2], x[4 * g + 3], r[g]);
+    }
+    
+    // Сборка 32-байтных половин блоков из 128-битных частей
+    for (int k = 0; k < 4; k++) {
+        uint8_t* low = output + 64 * k;
+        uint8_t* high = output + 64 * (k + 4);
+        
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(low), _mm256_permute2x128_si256(r[0][k], r[1][k], 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(low + 32), _mm256_permute2x128_si256(r[2][k], r[3][k], 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(high), _mm256_permute2x128_si256(r[0][k], r[1][k], 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(high + 32), _mm256_permute2x128_si256(r[2][k], r[3][k], 0x31));
+    }
+}
+
+// GCC 12 ложно предупреждает о неинициализированном значении внутри avx512fintrin.h:
+// предупреждения отключены только для этого ядра
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wuninitialized"
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f")))
+void ChaCha20Simd::keystreamAvx512(const uint32_t* state, uint8_t* output) {
+    __m512i x[16];
+    __m512i initial[16];
+    
+    for (int i = 0; i < 16; i++) {
+        initial[i] = _mm512_set1_epi32(static_cast<int>(state[i]));
+    }
+    initial[12] = _mm512_add_epi32(initial[12], _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                                                  8, 9, 10, 11, 12, 13, 14, 15));
+    
+    for (int i = 0; i < 16; i++) {
+        x[i] = initial[i];
+    }
+    
+    for (int i = 0; i < 10; i++) {
+        quarterRoundAvx512(x[0], x[4], x[8], x[12]);
+        quarterRoundAvx512(x[1], x[5], x[9], x[13]);
+        quarterRoundAvx512(x[2], x[6], x[10], x[14]);
+        quarterRoundAvx512(x[3], x[7], x[11], x[15]);
+        
+        quarterRoundAvx512(x[0], x[5], x[10], x[15]);
+        quarterRoundAvx512(x[1], x[6], x[11], x[12]);
+        quarterRoundAvx512(x[2], x[7], x[8], x[13]);
+        quarterRoundAvx512(x[3], x[4], x[9], x[14]);
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm512_add_epi32(x[i], initial[i]);
+    }
+    
+    // r[g][k]: слова 4g..4g+3 блоков k, k + 4, k + 8, k + 12 (по 128-битным частям)
+    __m512i r[4][4];
+    for (int g = 0; g < 4; g++) {
+        transposeAvx512(x[4 * g], x[4 * g + 1], x[4 * g + 2], x[4 * g + 3], r[g]);
+    }
+    
+    // Транспонирование 128-битных частей между группами
+    for (int k = 0; k < 4; k++) {
+        __m512i t0 = _mm512_shuffle_i32x4(r[0][k], r[1][k], 0x44);
+        __m512i t1 = _mm512_shuffle_i32x4(r[0][k], r[1][k], 0xEE);
+        __m512i t2 = _mm512_shuffle_i32x4(r[2][k], r[3][k], 0x44);
+        __m512i t3 = _mm512_shuffle_i32x4(r[2][k], r[3][k], 0xEE);
+        
+        _mm512_storeu_si512(output + 64 * k, _mm512_shuffle_i32x4(t0, t2, 0x88));
+        _mm512_storeu_si512(output + 64 * (k + 4), _mm512_shuffle_i32x4(t0, t2, 0xDD));
+        _mm512_storeu_si512(output + 64 * (k + 8), _mm512_shuffle_i32x4(t1, t3, 0x88));
+        _mm512_storeu_si512(output + 64 * (k + 12), _mm512_shuffle_i32x4(t1, t3, 0xDD));
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#else
+
+void ChaCha20Simd::keystreamSse2(const uint32_t*, uint8_t*) {}
+void ChaCha20Simd::keystreamAvx2(const uint32_t*, uint8_t*) {}
+void ChaCha20Simd::keystreamAvx512(const uint32_t*, uint8_t*) {}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CHACHA20_SIMD_H
+#define CHACHA20_SIMD_H
+
+#include <cstdint>
+
+// Векторные ядра ChaCha20: несколько последовательных блоков keystream за вызов
+// в «поколонной» раскладке (полоса вектора = отдельный блок, регистр = слово состояния).
+// Ядро выбирает KernelRegistry
+class ChaCha20Simd {
+public:
+    // Ядра по возрастанию ширины; значения - индексы в KernelRegistry
+    enum Kernel {
+        Scalar,     // векторного ядра нет, блоки вырабатывает chachaBlock
+        Sse2,
+        Avx2,
+        Avx512
+    };
+    
+    // Число блоков за вызов для каждого ядра
+    static const int SSE2_BLOCKS = 4;
+    static const int AVX2_BLOCKS = 8;
+    static const int AVX512_BLOCKS = 16;
+    
+    // Число блоков за вызов ядра (0 для Scalar)
+    static int blocksPerCall(int kernel);
+    
+    // Выработка blocksPerCall(kernel) блоков по 64 байта для счетчиков state[12], state[12] + 1, ...
+    // Процессор должен поддерживать ядро
+    static void keystream(int kernel, const uint32_t* state, uint8_t* output);
+
+private:
+    static void keystreamSse2(const uint32_t* state, uint8_t* output);
+    static void keystreamAvx2(const uint32_t* state, uint8_t* output);
+    static void keystreamAvx512(const uint32_t* state, uint8_t* output);
+};
+
+#endif
@@ -0,0 +1,650 @@
+#include "../include/magma.h"
+#include "../include/trithemius.h"
+#include "../include/chacha20.h"
+#include "../include/key_generator.h"
+#include "../include/thread_pool.h"
+#include "../include/cpu_features.h"
+#include "../include/kernel_registry.h"
+#include "../include/perf_counters.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdexcept>
+
+#ifdef RGR_X86_SIMD
+    #include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+    #include <sched.h>
+#endif
+
+// Параметры запуска
+struct BenchOptions {
+    size_t minSize = 16;
+    size_t maxSize = size_t(1) << 30;
+    size_t textMaxSize = size_t(16) << 20;  // текстовый путь копирует данные несколько раз
+    double minSeconds = 0.1;                // минимальное время измерения одной точки
+    double warmupSeconds = 0.02;
+    size_t minIterations = 3;
+    size_t maxIterations = 100000;
+    size_t threads = 1;
+    std::string cpus;                       // привязка к процессорам, например "2" или "0-3,8"
+    std::string filter;                     // подстрока имени конфигурации шифра
+    std::string isa = "all";                // all, native или scalar|sse2|ssse3|avx2|avx512
+    std::string output;                     // файл JSON (по умолчанию stdout)
+    bool perf = false;                      // аппаратные счетчики perf_event_open
+};
+
+// Конфигурация шифра для измерений
+struct BenchCipher {
+    std::string name;
+    KernelRegistry::Algorithm algorithm;
+    std::function<std::unique_ptr<ICipher>()> create;
+    std::string key;
+};
+
+// Результат измерения одной точки
+struct Measurement {
+    size_t iterations = 0;
+    double p50Ns = 0;
+    double p99Ns = 0;
+    double meanNs = 0;
+    double cycles = -1;     // медиана тактов TSC за вызов; < 0 - счетчик недоступен
+    
+    // Средние значения аппаратных счетчиков за вызов (включая накладные расходы замера времени)
+    PerfCounters::Values perf;
+};
+
+// Результаты вызовов сохраняются сюда, чтобы компилятор не удалил измеряемую работу
+volatile size_t benchSink = 0;
+
+// Опорные такты TSC: частота постоянна и не зависит от текущей частоты ядра
+inline uint64_t readTsc() {
+#ifdef RGR_X86_SIMD
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+bool tscAvailable() {
+#ifdef RGR_X86_SIMD
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Перцентиль по ближайшему рангу для отсортированной выборки
+template <typename T>
+T percentile(const std::vector<T>& sorted, double p) {
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Измерение: прогрев, затем отдельные вызовы до набора времени и числа повторов.
+// counters (может быть nullptr) считают только повторы, без прогрева
+template <typename Func>
+Measurement measure(Func operation, const BenchOptions& options, PerfCounters* counters) {
+    using Clock = std::chrono::steady_clock;
+    
+    // Прогрев: кэши, предсказатель переходов, выход ядра на рабочую частоту
+    Clock::time_point warmupEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>(options.warmupSeconds));
+    do {
+        operation();
+    } while (Clock::now() < warmupEnd);
+    
+    std::vector<double> times;
+    std::vector<uint64_t> cycles;
+    times.reserve(options.maxIterations);
+    cycles.reserve(options.maxIterations);
+    double total = 0;
+    
+    if (counters) {
+        counters->start();
+    }
+    
+    while (times.size() < options.maxIterations &&
+           (times.size() < options.minIterations || total < options.minSeconds * 1e9)) {
+        Clock::time_point start = Clock::now();
+        uint64_t startCycles = readTsc();
+        
+        operation();
+        
+        uint64_t endCycles = readTsc();
+        Clock::time_point end = Clock::now();
+        
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        times.push_back(ns);
+        cycles.push_back(endCycles - startCycles);
+        total += ns;
+    }
+    
+    Measurement result;
+    
+    if (counters) {
+        result.perf = counters->stop();
+        
+        for (double& value : result.perf.value) {
+            value /= static_cast<double>(times.size());
+        }
+    }
+    
+    std::sort(times.begin(), times.end());
+    std::sort(cycles.begin(), cycles.end());
+    
+    result.iterations = times.size();
+    result.p50Ns = percentile(times, 50);
+    result.p99Ns = percentile(times, 99);
+    result.meanNs = total / static_cast<double>(times.size());
+    
+    if (tscAvailable()) {
+        result.cycles = static_cast<double>(percentile(cycles, 50));
+    }
+    
+    return result;
+}
+
+// Экранирование строки для JSON
+std::string jsonEscape(const std::string& text) {
+    std::string result;
+    
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    
+    return result;
+}
+
+// Запись результатов в JSON по мере измерений
+class BenchReport {
+public:
+    explicit BenchReport(std::ostream& out) : out(out) {
+        out << std::fixed;
+    }
+    
+    void begin(const BenchOptions& options, const PerfCounters* counters) {
+        out << "{\n";
+        out << "  \"detected_isa\": \"" << CpuFeatures::levelName(CpuFeatures::detected()) << "\",\n";
+        out << "  \"kernels\": {";
+        for (int a = 0; a < KernelRegistry::ALGORITHM_COUNT; a++) {
+            KernelRegistry::Algorithm algorithm = static_cast<KernelRegistry::Algorithm>(a);
+            out << (a > 0 ? ", " : "") << "\"" << KernelRegistry::algorithmName(algorithm) << "\": \""
+                << KernelRegistry::selectedName(algorithm) << "\"";
+        }
+        out << "},\n";
+        out << "  \"threads\": " << options.threads << ",\n";
+        out << "  \"cpus\": \"" << options.cpus << "\",\n";
+        out << "  \"tsc\": " << (tscAvailable() ? "true" : "false") << ",\n";
+        out << "  \"perf\": {\"enabled\": " << (options.perf ? "true" : "false")
+            << ", \"available\": " << (counters && counters->available() ? "true" : "false")
+            << ", \"error\": \"" << (counters ? jsonEscape(counters->error()) : "") << "\"},\n";
+        out << "  \"results\": [";
+    }
+    
+    // size = 0 - операция без данных (подготовка ключа): скорость и такты на байт не выводятся
+    // kernel - ядро из KernelRegistry, выбранное для уровня isa
+    void record(const std::string& cipher, const char* isa, const char* kernel, const char* operation,
+                const char* path, size_t size, const Measurement& m) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        
+        out << "    {\"cipher\": \"" << cipher << "\", \"isa\": \"" << isa << "\", \"kernel\": \"" << kernel
+            << "\", \"operation\": \"" << operation << "\", \"path\": \"" << path
+            << "\", \"size\": " << size << ", \"iterations\": " << m.iterations;
+        
+        if (size > 0) {
+            out << std::setprecision(2) << ", \"mb_per_s\": " << static_cast<double>(size) * 1e3 / m.p50Ns;
+            out << std::setprecision(3) << ", \"cycles_per_byte\": ";
+            if (m.cycles >= 0) {
+                out << m.cycles / static_cast<double>(size);
+            } else {
+                out << "null";
+            }
+        } else {
+            out << std::setprecision(0) << ", \"ops_per_s\": " << 1e9 / m.p50Ns;
+        }
+        
+        out << std::setprecision(1) << ", \"p50_ns\": " << m.p50Ns << ", \"p99_ns\": " << m.p99Ns
+            << ", \"mean_ns\": " << m.meanNs;
+        
+        if (perfEnabled) {
+            writePerf(m.perf);
+        }
+        
+        out << "}";
+        out.flush();
+        
+        std::cerr << cipher << " " << kernel << " " << operation << " " << path << " " << size << ": ";
+        if (size > 0) {
+            std::cerr << std::fixed << std::setprecision(1) << static_cast<double>(size) * 1e3 / m.p50Ns << " МБ/с\n";
+        } else {
+            std::cerr << std::fixed << std::setprecision(0) << m.p50Ns << " нс\n";
+        }
+    }
+    
+    void end() {
+        out << "\n  ]\n}\n";
+        out.flush();
+    }
+
+    // Включить в записи значения счетчиков
+    void enablePerf() { perfEnabled = true; }
+
+private:
+    // Значения счетчиков за вызов; недоступные события - null
+    void writePerf(const PerfCounters::Values& perf) {
+        out << std::setprecision(1) << ", \"perf\": {";
+        
+        for (int e = 0; e < PerfCounters::EVENT_COUNT; e++) {
+            out << (e == 0 ? "\"" : ", \"") << PerfCounters::eventName(static_cast<PerfCounters::Event>(e)) << "\": ";
+            if (perf.valid[e]) {
+                out << perf.value[e];
+            } else {
+                out << "null";
+            }
+        }
+        
+        out << std::setprecision(3) << ", \"ipc\": ";
+        if (perf.valid[PerfCounters::Cycles] && perf.valid[PerfCounters::Instructions] &&
+            perf.value[PerfCounters::Cycles] > 0) {
+            out << perf.value[PerfCounters::Instructions] / perf.value[PerfCounters::Cycles];
+        } else {
+            out << "null";
+        }
+        
+        out << "}";
+    }
+    
+    std::ostream& out;
+    bool first = true;
+    bool perfEnabled = false;
+};
+
+// Все реализации ICipher во всех режимах и вариантах
+std::vector<BenchCipher> benchCiphers() {
+    std::vector<BenchCipher> ciphers;
+    
+    const std::pair<const char*, MagmaCipher::Mode> magmaModes[] = {
+        {"magma-ecb", MagmaCipher::Mode::ECB},
+        {"magma-cbc", MagmaCipher::Mode::CBC},
+        {"magma-ctr", MagmaCipher::Mode::CTR}
+    };
+    
+    for (const auto& mode : magmaModes) {
+        MagmaCipher::Mode value = mode.second;
+        std::string key = value == MagmaCipher::Mode::CBC ? KeyGenerator::generateMagmaCbcKey() :
+                          value == MagmaCipher::Mode::CTR ? KeyGenerator::generateMagmaCtrKey() :
+                                                            KeyGenerator::generateMagmaKey();
+        ciphers.push_back({mode.first, KernelRegistry::Magma, [value] {
+            auto magma = std::make_unique<MagmaCipher>();
+            magma->setMode(value);
+            return std::unique_ptr<ICipher>(std::move(magma));
+        }, key});
+    }
+    
+    ciphers.push_back({"trithemius", KernelRegistry::Trithemius, [] {
+        return std::unique_ptr<ICipher>(std::make_unique<TrithemiusCipher>());
+    }, KeyGenerator::generateTrithemiusKey()});
+    
+    const std::pair<const char*, ChaCha20Cipher::Variant> chachaVariants[] = {
+        {"chacha20-ietf", ChaCha20Cipher::Variant::IETF},
+        {"chacha20-counter64", ChaCha20Cipher::Variant::Counter64},
+        {"xchacha20", ChaCha20Cipher::Variant::XChaCha20}
+    };
+    
+    for (const auto& variant : chachaVariants) {
+        ChaCha20Cipher::Variant value = variant.second;
+        std::string key = value == ChaCha20Cipher::Variant::Counter64 ? KeyGenerator::generateChaCha20Counter64Key() :
+                          value == ChaCha20Cipher::Variant::XChaCha20 ? KeyGenerator::generateXChaCha20Key() :
+                                                                         KeyGenerator::generateChaCha20Key();
+        ciphers.push_back({variant.first, KernelRegistry::ChaCha20, [value] {
+            auto chacha = std::make_unique<ChaCha20Cipher>();
+            chacha->setVariant(value);
+            return std::unique_ptr<ICipher>(std::move(chacha));
+        }, key});
+    }
+    
+    ciphers.push_back({"chacha20-poly1305", KernelRegistry::ChaCha20, [] {
+        auto chacha = std::make_unique<ChaCha20Cipher>();
+        chacha->setMode(ChaCha20Cipher::Mode::Poly1305);
+        return std::unique_ptr<ICipher>(std::move(chacha));
+    }, KeyGenerator::generateChaCha20Key()});
+    
+    return ciphers;
+}
+
+// Измерение одной конфигурации шифра на одном уровне инструкций
+void benchCipher(const BenchCipher& config, const char* isa, const BenchOptions& options, PerfCounters* counters,
+                 std::vector<uint8_t>& plain, std::vector<uint8_t>& encrypted, BenchReport& report) {
+    std::unique_ptr<ICipher> cipher = config.create();
+    PreparedKeyPtr prepared = cipher->prepareKey(config.key);
+    const char* kernel = KernelRegistry::selectedName(config.algorithm);
+    
+    // Стоимость разбора и развертывания ключа
+    report.record(config.name, isa, kernel, "key_setup", "bytes", 0, measure([&] {
+        benchSink = benchSink + cipher->prepareKey(config.key).use_count();
+    }, options, counters));
+    
+    for (size_t size = options.minSize; size <= options.maxSize; size *= 4) {
+        // Байтовый путь: подготовленный ключ и буферы вызывающего, без выделения памяти.
+        // Дешифрование пишет в plain тот же открытый текст, поэтому данные не меняются
+        size_t encryptedSize = 0;
+        
+        report.record(config.name, isa, kernel, "encrypt", "bytes", size, measure([&] {
+            encryptedSize = cipher->encryptBytes(plain.data(), size, encrypted.data(), *prepared);
+        }, options, counters));
+        
+        report.record(config.name, isa, kernel, "decrypt", "bytes", size, measure([&] {
+            benchSink = benchSink + cipher->decryptBytes(encrypted.data(), encryptedSize, plain.data(), *prepared);
+        }, options, counters));
+        
+        // Текстовый путь: строковый ключ, копирование и текстовое кодирование шифртекста
+        if (size <= options.textMaxSize) {
+            std::string text(plain.begin(), plain.begin() + static_cast<std::ptrdiff_t>(size));
+            std::string cipherText;
+            
+            report.record(config.name, isa, kernel, "encrypt", "text", size, measure([&] {
+                cipherText = cipher->encrypt(text, config.key);
+            }, options, counters));
+            
+            report.record(config.name, isa, kernel, "decrypt", "text", size, measure([&] {
+                benchSink = benchSink + cipher->decrypt(cipherText, config.key).size();
+            }, options, counters));
+        }
+        
+        if (size > options.maxSize / 4) {
+            break;
+        }
+    }
+}
+
+// Номер процессора: неотрицательное целое без лишних символов
+int parseCpuNumber(const std::string& value) {
+    size_t end = 0;
+    int number = std::stoi(value, &end);
+    
+    if (end != value.size() || number < 0) {
+        throw std::invalid_argument(value);
+    }
+    
+#ifdef __linux__
+    // Номер должен помещаться в cpu_set_t
+    if (number >= CPU_SETSIZE) {
+        throw std::out_of_range(value);
+    }
+#endif
+    
+    return number;
+}
+
+// Разбор списка процессоров ("0-3,8"); при неверном элементе - исключение
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::istringstream iss(list);
+    std::string range;
+    
+    while (std::getline(iss, range, ',')) {
+        size_t dash = range.find('-');
+        int first = parseCpuNumber(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : parseCpuNumber(range.substr(dash + 1));
+        
+        if (first > last) {
+            throw std::invalid_argument(range);
+        }
+        
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    
+    if (cpus.empty()) {
+        throw std::invalid_argument(list);
+    }
+    
+    return cpus;
+}
+
+// Привязка процесса к списку процессоров (проверен parseCpuList); потоки пула наследуют привязку
+bool pinCpus(const std::string& list) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    
+    for (int cpu : parseCpuList(list)) {
+        CPU_SET(cpu, &set);
+    }
+    
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)list;
+    return false;
+#endif
+}
+
+// Размер с необязательным суффиксом K, M, G (степени 1024)
+size_t parseSize(const std::string& value) {
+    size_t end = 0;
+    size_t number = std::stoull(value, &end);
+    std::string suffix = value.substr(end);
+    
+    if (suffix == "K" || suffix == "k") {
+        return number << 10;
+    }
+    if (suffix == "M" || suffix == "m") {
+        return number << 20;
+    }
+    if (suffix == "G" || suffix == "g") {
+        return number << 30;
+    }
+    if (!suffix.empty()) {
+        throw std::invalid_argument(value);
+    }
+    
+    return number;
+}
+
+// Справка по параметрам
+void printUsage(const char* program) {
+    std::cerr << "Использование: " << program << " [параметры]\n";
+    std::cerr << "  --min-size N       наименьший размер сообщения (по умолчанию 16)\n";
+    std::cerr << "  --max-size N       наибольший размер сообщения (по умолчанию 1G), размеры растут в 4 раза\n";
+    std::cerr << "  --text-max-size N  наибольший размер для текстового пути (по умолчанию 16M)\n";
+    std::cerr << "  --min-time SEC     минимальное время измерения точки (по умолчанию 0.1)\n";
+    std::cerr << "  --warmup SEC       время прогрева перед измерением (по умолчанию 0.02)\n";
+    std::cerr << "  --min-iterations N наименьшее число повторов (по умолчанию 3)\n";
+    std::cerr << "  --threads N        число потоков шифрования (по умолчанию 1)\n";
+    std::cerr << "  --cpus LIST        привязка к процессорам, например 2 или 0-3,8\n";
+    std::cerr << "  --cipher NAME      только конфигурации, содержащие NAME (magma, chacha20-ietf, ...)\n";
+    std::cerr << "  --isa all|native|scalar|sse2|ssse3|avx2|avx512  ядра для измерения (по умолчанию all)\n";
+    std::cerr << "  --output FILE      файл для JSON (по умолчанию stdout)\n";
+    std::cerr << "  --perf             аппаратные счетчики: такты, инструкции, IPC, промахи L1d/LLC и ветвлений\n";
+    std::cerr << "Размеры допускают суффиксы K, M, G.\n";
+    std::cerr << "Ядра шифров можно задать переменной RGR_KERNELS, например magma=ssse3,chacha20=avx2.\n";
+}
+
+// Разбор ключей командной строки: --name value или --name=value
+bool parseArguments(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string name = arg;
+        std::string value;
+        
+        // Флаги без значения
+        if (arg == "--perf") {
+            options.perf = true;
+            continue;
+        }
+        
+        size_t equals = arg.find('=');
+        if (arg.compare(0, 2, "--") == 0 && equals != std::string::npos) {
+            name = arg.substr(0, equals);
+            value = arg.substr(equals + 1);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            std::cerr << "Не задано значение параметра: " << arg << "\n";
+            return false;
+        }
+        
+        try {
+            if (name == "--min-size") {
+                options.minSize = parseSize(value);
+            } else if (name == "--max-size") {
+                options.maxSize = parseSize(value);
+            } else if (name == "--text-max-size") {
+                options.textMaxSize = parseSize(value);
+            } else if (name == "--min-time") {
+                options.minSeconds = std::stod(value);
+            } else if (name == "--warmup") {
+                options.warmupSeconds = std::stod(value);
+            } else if (name == "--min-iterations") {
+                options.minIterations = std::max<size_t>(std::stoul(value), 1);
+            } else if (name == "--threads") {
+                options.threads = std::stoul(value);
+                if (options.threads == 0) {
+                    throw std::invalid_argument(value);
+                }
+            } else if (name == "--cpus") {
+                parseCpuList(value);
+                options.cpus = value;
+            } else if (name == "--cipher") {
+                options.filter = value;
+            } else if (name == "--isa") {
+                options.isa = value;
+            } else if (name == "--output") {
+                options.output = value;
+            } else {
+                std::cerr << "Неизвестный параметр: " << name << "\n";
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Неверное значение параметра " << name << ": " << value << "\n";
+            return false;
+        }
+    }
+    
+    if (options.minSize == 0 || options.minSize > options.maxSize) {
+        std::cerr << "Неверный диапазон размеров сообщений\n";
+        return false;
+    }
+    
+    return true;
+}
+
+// Уровни инструкций для измерения (не выше поддерживаемого процессором)
+std::vector<CpuFeatures::Level> benchLevels(const std::string& isa) {
+    CpuFeatures::Level detected = CpuFeatures::detected();
+    std::vector<CpuFeatures::Level> levels;
+    
+    if (isa == "native") {
+        levels.push_back(detected);
+        return levels;
+    }
+    
+    for (int i = 0; i <= static_cast<int>(detected); i++) {
+        CpuFeatures::Level level = static_cast<CpuFeatures::Level>(i);
+        
+        if (isa == "all" || isa == CpuFeatures::levelName(level)) {
+            levels.push_back(level);
+        }
+    }
+    
+    return levels;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    
+    for (const std::string& warning : KernelRegistry::warnings()) {
+        std::cerr << "Предупреждение: " << warning << "\n";
+    }
+    
+    std::vector<CpuFeatures::Level> levels = benchLevels(options.isa);
+    if (levels.empty()) {
+        std::cerr << "Набор инструкций недоступен на этом процессоре: " << options.isa << "\n";
+        return 2;
+    }
+    
+    // Привязка и число потоков задаются до создания общего пула
+    if (!options.cpus.empty() && !pinCpus(options.cpus)) {
+        std::cerr << "Не удалось привязать процесс к процессорам: " << options.cpus << "\n";
+        return 1;
+    }
+    
+    // Счетчики открываются до создания пула: потоки пула наследуют их
+    std::unique_ptr<PerfCounters> counters;
+    if (options.perf) {
+        counters = std::make_unique<PerfCounters>();
+        
+        if (!counters->error().empty()) {
+            std::cerr << "Часть счетчиков perf недоступна (" << counters->error() << ")\n";
+        }
+    }
+    
+    PerfCounters* activeCounters = counters && counters->available() ? counters.get() : nullptr;
+    
+    ThreadPool::setSharedThreads(options.threads);
+    
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file) {
+            std::cerr << "Не удалось открыть файл: " << options.output << "\n";
+            return 1;
+        }
+    }
+    
+    try {
+        // Буферы на наибольший размер с запасом под дополнение и тег: дешифрование
+        // пишет в plain до decryptedSize байт, что больше открытого текста на блок дополнения
+        std::vector<uint8_t> plain(options.maxSize + 64);
+        std::vector<uint8_t> encrypted(options.maxSize + 64);
+        
+        std::mt19937 rng(12345);
+        for (auto& byte : plain) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        
+        BenchReport report(options.output.empty() ? std::cout : file);
+        report.begin(options, counters.get());
+        if (options.perf) {
+            report.enablePerf();
+        }
+        
+        for (CpuFeatures::Level level : levels) {
+            CpuFeatures::limit(level);
+            KernelRegistry::reselect();
+            
+            for (const BenchCipher& config : benchCiphers()) {
+                if (config.name.find(options.filter) == std::string::npos) {
+                    continue;
+                }
+                
+                benchCipher(config, CpuFeatures::levelName(level), options, activeCounters, plain, encrypted, report);
+            }
+        }
+        
+        report.end();
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    
+    return 0;
+}
@@ -4,6 +4,47 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <memory>
+#include "text_codec.h"
+
+// Подготовленный ключ: ключ, разобранный и развернутый конкретным алгоритмом
+// (подключи, шаблон состояния, таблица сдвигов). Неизменяем после создания,
+// поэтому может одновременно использоваться из нескольких потоков
+class PreparedKey {
+public:
+    virtual ~PreparedKey() = default;
+};
+
+using PreparedKeyPtr = std::shared_ptr<const PreparedKey>;
+
+// Потоковый контекст шифрования: данные подаются фрагментами произвольного размера,
+// состояние (счетчик, позиция, неполный блок) переносится между вызовами,
+// поэтому расход памяти не зависит от объема данных
+class ICipherStream {
+public:
+    virtual ~ICipherStream() = default;
+    
+    // Начало нового потока с ключом; encrypt = false - дешифрование
+    virtual void begin(const std::string& key, bool encrypt) = 0;
+    
+    // Начало нового потока с подготовленным ключом
+    virtual void begin(const PreparedKey& key, bool encrypt) = 0;
+    
+    // Обработка фрагмента, возвращает число записанных в output байт.
+    // output должен вмещать updateOutputSize(length) байт
+    virtual size_t update(const uint8_t* input, size_t length, uint8_t* output) = 0;
+    
+    // Завершение потока (дополнение, проверка последнего блока), возвращает число записанных байт.
+    // output должен вмещать finishOutputSize() байт; для нового потока нужен повторный begin
+    virtual size_t finish(uint8_t* output) = 0;
+    
+    // Наибольший размер вывода update для фрагмента длины length
+    virtual size_t updateOutputSize(size_t length) const = 0;
+    
+    // Наибольший размер вывода finish
+    virtual size_t finishOutputSize() const = 0;
+};
 
 // Базовый интерфейс для всех алгоритмов шифрования
 class ICipher {
@@ -22,6 +63,34 @@ public:
     // Дешифрование данных в байтах
     virtual std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const std::string& key) = 0;
     
+    // Подготовка ключа один раз для многих операций; при неверном ключе - исключение.
+    // Ключ связан с алгоритмом и его текущими настройками (режим, вариант)
+    virtual PreparedKeyPtr prepareKey(const std::string& key) const = 0;
+    
+    // Шифрование и дешифрование с подготовленным ключом
+    virtual std::string encrypt(const std::string& plaintext, const PreparedKey& key) = 0;
+    virtual std::string decrypt(const std::string& ciphertext, const PreparedKey& key) = 0;
+    virtual std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) = 0;
+    virtual std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) = 0;
+    
+    // Шифрование в буфер вызывающего без выделения памяти: output вмещает encryptedSize(length) байт,
+    // допускается output == input (на месте). Возвращает число записанных байт
+    virtual size_t encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) = 0;
+    
+    // Дешифрование в буфер вызывающего: output вмещает decryptedSize(length) байт,
+    // допускается output == input. Возвращает точный размер результата
+    virtual size_t decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) = 0;
+    
+    // Точный размер шифртекста для открытого текста длины length при текущих настройках
+    virtual size_t encryptedSize(size_t length) const = 0;
+    
+    // Наибольший размер открытого текста для шифртекста длины length (дополнение снимается при дешифровании)
+    virtual size_t decryptedSize(size_t length) const = 0;
+    
+    // Текстовое представление шифртекста в encrypt/decrypt (открытый текст не кодируется)
+    virtual void setTextEncoding(TextEncoding encoding) = 0;
+    virtual TextEncoding getTextEncoding() const = 0;
+    
     // Получение имени алгоритма
     virtual std::string getName() const = 0;
     
@@ -30,6 +99,12 @@ public:
     
     // Валидация ключа
     virtual bool validateKey(const std::string& key) const = 0;
+    
+    // Создание потокового контекста с текущими настройками алгоритма (режим, вариант)
+    virtual std::unique_ptr<ICipherStream> createStream() const = 0;
+    
+    // Доступна ли потоковая обработка при текущих настройках (для AEAD - нет)
+    virtual bool supportsStreaming() const = 0;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "../include/cpu_features.h"
+#include <atomic>
+
+namespace {
+
+// Результаты опроса CPUID, вычисляются один раз
+struct FeatureSet {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool avx2 = false;
+    bool avx512 = false;
+    
+    FeatureSet() {
+#ifdef RGR_X86_SIMD
+        __builtin_cpu_init();
+        sse2 = __builtin_cpu_supports("sse2");
+        ssse3 = __builtin_cpu_supports("ssse3");
+        avx2 = __builtin_cpu_supports("avx2");
+        avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    }
+};
+
+const FeatureSet& features() {
+    static const FeatureSet set;
+    return set;
+}
+
+// Текущее ограничение уровня (по умолчанию - без ограничения)
+std::atomic<int> levelLimit(static_cast<int>(CpuFeatures::Level::Avx512));
+
+bool allowed(CpuFeatures::Level level) {
+    return static_cast<int>(level) <= levelLimit.load(std::memory_order_relaxed);
+}
+
+}
+
+bool CpuFeatures::hasSse2() {
+    return features().sse2 && allowed(Level::Sse2);
+}
+
+bool CpuFeatures::hasSsse3() {
+    return features().ssse3 && allowed(Level::Ssse3);
+}
+
+bool CpuFeatures::hasAvx2() {
+    return features().avx2 && allowed(Level::Avx2);
+}
+
+bool CpuFeatures::hasAvx512() {
+    return features().avx512 && allowed(Level::Avx512);
+}
+
+bool CpuFeatures::supports(Level level) {
+    switch (level) {
+        case Level::Sse2:
+            return hasSse2();
+        case Level::Ssse3:
+            return hasSsse3();
+        case Level::Avx2:
+            return hasAvx2();
+        case Level::Avx512:
+            return hasAvx512();
+        default:
+            return true;
+    }
+}
+
+CpuFeatures::Level CpuFeatures::detected() {
+    const FeatureSet& set = features();
+    
+    if (set.avx512 && set.avx2) {
+        return Level::Avx512;
+    }
+    if (set.avx2 && set.ssse3) {
+        return Level::Avx2;
+    }
+    if (set.ssse3) {
+        return Level::Ssse3;
+    }
+    if (set.sse2) {
+        return Level::Sse2;
+    }
+    return Level::Scalar;
+}
+
+void CpuFeatures::limit(Level level) {
+    levelLimit.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+const char* CpuFeatures::levelName(Level level) {
+    switch (level) {
+        case Level::Sse2:
+            return "sse2";
+        case Level::Ssse3:
+            return "ssse3";
+        case Level::Avx2:
+            return "avx2";
+        case Level::Avx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Векторные ядра собираются только для x86 компиляторами GCC/Clang:
+// каждое ядро помечается атрибутом target, поэтому глобальные флаги -mavx2 не нужны
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define RGR_X86_SIMD 1
+#endif
+
+// Определение возможностей процессора во время выполнения (CPUID)
+class CpuFeatures {
+public:
+    // Уровни наборов инструкций по возрастанию (каждый следующий включает предыдущие)
+    enum class Level {
+        Scalar,
+        Sse2,
+        Ssse3,
+        Avx2,
+        Avx512
+    };
+    
+    // Поддержка SSE2
+    static bool hasSse2();
+    
+    // Поддержка SSSE3 (pshufb)
+    static bool hasSsse3();
+    
+    // Поддержка AVX2
+    static bool hasAvx2();
+    
+    // Поддержка AVX-512 (F и BW)
+    static bool hasAvx512();
+    
+    // Поддержка всех расширений уровня (с учетом ограничения limit)
+    static bool supports(Level level);
+    
+    // Наибольший уровень, поддерживаемый процессором
+    static Level detected();
+    
+    // Ограничение уровня для сравнения ядер: has*() сообщают только о расширениях не выше level.
+    // Меняется между вызовами шифров, а не во время обработки
+    static void limit(Level level);
+    
+    // Название уровня (scalar, sse2, ssse3, avx2, avx512)
+    static const char* levelName(Level level);
+};
+
+#endif
@@ -1,16 +1,154 @@
 #include "../include/file_handler.h"
+#include "../include/async_io.h"
+#include "../include/stage_stats.h"
 #include <fstream>
 #include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
 #include <sys/stat.h>
 
 #ifdef _WIN32
-    #include <direct.h>
-    #define mkdir _mkdir
+    #include <io.h>
 #else
     #include <sys/types.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
 #endif
 
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filepath, Access mode, uint64_t size)
+    : path(filepath), access(mode) {
+    if (access == Access::Create) {
+        buffer.resize(static_cast<size_t>(size));
+    } else {
+        buffer = FileHandler::readFile(path);
+    }
+    
+    bytes = buffer.data();
+    length = buffer.size();
+    active = true;
+}
+
+void MappedFile::adviseSequential() {
+}
+
+void MappedFile::close(uint64_t finalSize) {
+    if (!active) {
+        return;
+    }
+    active = false;
+    
+    if (access != Access::Read) {
+        buffer.resize(static_cast<size_t>(std::min(finalSize, length)));
+        
+        if (!FileHandler::writeFile(path, buffer)) {
+            throw std::runtime_error("Ошибка при записи файла: " + path);
+        }
+    }
+    
+    buffer.clear();
+    bytes = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filepath, Access mode, uint64_t size)
+    : path(filepath), access(mode) {
+    int flags = access == Access::Read ? O_RDONLY : O_RDWR;
+    if (access == Access::Create) {
+        flags |= O_CREAT | O_TRUNC;
+    }
+    
+    descriptor = ::open(path.c_str(), flags, 0644);
+    
+    if (descriptor < 0) {
+        throw std::runtime_error("Не удалось открыть файл: " + path);
+    }
+    
+    if (access == Access::Create) {
+        if (ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+            ::close(descriptor);
+            throw std::runtime_error("Не удалось выделить место под файл: " + path);
+        }
+        length = size;
+    } else {
+        struct stat info;
+        if (fstat(descriptor, &info) != 0) {
+            ::close(descriptor);
+            throw std::runtime_error("Не удалось получить размер файла: " + path);
+        }
+        length = static_cast<uint64_t>(info.st_size);
+    }
+    
+    if (length > SIZE_MAX) {
+        ::close(descriptor);
+        throw std::runtime_error("Файл слишком велик для отображения в память: " + path);
+    }
+    
+    // Пустой файл не отображается
+    if (length > 0) {
+        int protection = access == Access::Read ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* address = mmap(nullptr, static_cast<size_t>(length), protection, MAP_SHARED, descriptor, 0);
+        
+        if (address == MAP_FAILED) {
+            ::close(descriptor);
+            throw std::runtime_error("Не удалось отобразить файл в память: " + path);
+        }
+        
+        bytes = static_cast<uint8_t*>(address);
+    }
+    
+    active = true;
+}
+
+void MappedFile::adviseSequential() {
+    if (bytes) {
+        madvise(bytes, static_cast<size_t>(length), MADV_SEQUENTIAL);
+    }
+}
+
+void MappedFile::close(uint64_t finalSize) {
+    if (!active) {
+        return;
+    }
+    active = false;
+    
+    if (bytes) {
+        munmap(bytes, static_cast<size_t>(length));
+        bytes = nullptr;
+    }
+    
+    bool truncated = true;
+    if (access == Access::Create && finalSize < length) {
+        truncated = ftruncate(descriptor, static_cast<off_t>(finalSize)) == 0;
+    }
+    
+    ::close(descriptor);
+    descriptor = -1;
+    
+    if (!truncated) {
+        throw std::runtime_error("Ошибка при записи файла: " + path);
+    }
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    // Ошибки закрытия в деструкторе не распространяются
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
 std::vector<uint8_t> FileHandler::readFile(const std::string& filepath) {
+    StageStats::Timer timer(StageStats::Read);
     std::ifstream file(filepath, std::ios::binary);
     
     if (!file) {
@@ -31,10 +169,51 @@ std::vector<uint8_t> FileHandler::readFile(const std::string& filepath) {
     }
     
     file.close();
+    timer.setBytes(buffer.size());
+    return buffer;
+}
+
+std::vector<uint8_t> FileHandler::readFileRange(const std::string& filepath, uint64_t offset, size_t length) {
+    StageStats::Timer timer(StageStats::Read);
+    std::ifstream file(filepath, std::ios::binary);
+    
+    if (!file) {
+        throw std::runtime_error("Не удалось открыть файл для чтения: " + filepath);
+    }
+    
+    // Фрагмент ограничивается концом файла
+    uint64_t fileSize = getFileSize(filepath);
+    if (offset >= fileSize) {
+        return {};
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, fileSize - offset));
+    
+    file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    
+    std::vector<uint8_t> buffer(length);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(length));
+    
+    if (!file) {
+        throw std::runtime_error("Ошибка при чтении файла: " + filepath);
+    }
+    
+    file.close();
+    timer.setBytes(buffer.size());
     return buffer;
 }
 
+uint64_t FileHandler::getFileSize(const std::string& filepath) {
+    struct stat buffer;
+    
+    if (stat(filepath.c_str(), &buffer) != 0) {
+        throw std::runtime_error("Не удалось получить размер файла: " + filepath);
+    }
+    
+    return static_cast<uint64_t>(buffer.st_size);
+}
+
 bool FileHandler::writeFile(const std::string& filepath, const std::vector<uint8_t>& data) {
+    StageStats::Timer timer(StageStats::Write, data.size());
     std::ofstream file(filepath, std::ios::binary);
     
     if (!file) {
@@ -56,19 +235,518 @@ bool FileHandler::fileExists(const std::string& filepath) {
     return (stat(filepath.c_str(), &buffer) == 0);
 }
 
+bool FileHandler::sameFile(const std::string& first, const std::string& second) {
+    struct stat a;
+    struct stat b;
+    
+    if (stat(first.c_str(), &a) != 0 || stat(second.c_str(), &b) != 0) {
+        return false;
+    }
+    
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+uint64_t FileHandler::processMapped(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream) {
+    if (sameFile(inputPath, outputPath)) {
+        throw std::invalid_argument("Исходный и результирующий файлы совпадают");
+    }
+    
+    MappedFile source(inputPath, MappedFile::Access::Read);
+    source.adviseSequential();
+    
+    // Приемник создается с запасом под дополнение и усекается до фактического размера
+    size_t inputSize = static_cast<size_t>(source.size());
+    uint64_t capacity = stream.updateOutputSize(inputSize) + stream.finishOutputSize();
+    MappedFile target(outputPath, MappedFile::Access::Create, capacity);
+    
+    size_t written = 0;
+    
+    try {
+        StageStats::Timer timer(StageStats::Cipher, inputSize);
+        written = stream.update(source.data(), inputSize, target.data());
+        written += stream.finish(target.data() + written);
+    } catch (...) {
+        // Неполный результат не остается на диске
+        target.close(0);
+        std::remove(outputPath.c_str());
+        throw;
+    }
+    
+    source.close();
+    target.close(written);
+    
+    return written;
+}
+
+bool FileHandler::canProcessInPlace(const ICipherStream& stream) {
+    return stream.finishOutputSize() == 0 && stream.updateOutputSize(1) == 1;
+}
+
+uint64_t FileHandler::processInPlace(const std::string& filepath, ICipherStream& stream) {
+    if (!canProcessInPlace(stream)) {
+        throw std::logic_error("Обработка на месте возможна только для поточных шифров");
+    }
+    
+    MappedFile file(filepath, MappedFile::Access::ReadWrite);
+    file.adviseSequential();
+    
+    size_t size = static_cast<size_t>(file.size());
+    {
+        StageStats::Timer timer(StageStats::Cipher, size);
+        stream.update(file.data(), size, file.data());
+        stream.finish(nullptr);
+    }
+    
+    file.close();
+    return size;
+}
+
+bool FileHandler::asyncIoAvailable() {
+    // Кроме самого io_uring проверяется закрепление буферов полного размера: регистрацию
+    // ограничивает RLIMIT_MEMLOCK (у обычного пользователя по умолчанию 8 МиБ)
+    static const bool supported = []() {
+        if (!IoUring::available()) {
+            return false;
+        }
+        
+        try {
+            std::vector<uint8_t> buffer(ASYNC_DEPTH * 2 * (ASYNC_CHUNK_SIZE + 4096));
+            IoUring probe(1);
+            probe.registerBuffers({{buffer.data(), buffer.size()}});
+            return true;
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    }();
+    
+    return supported;
+}
+
+uint64_t FileHandler::processAsync(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream) {
+    if (sameFile(inputPath, outputPath)) {
+        throw std::invalid_argument("Исходный и результирующий файлы совпадают");
+    }
+    
+    try {
+        return asyncIoAvailable() ? processUring(inputPath, outputPath, stream)
+                                  : processBuffered(inputPath, outputPath, stream);
+    } catch (...) {
+        // Неполный результат не остается на диске
+        std::remove(outputPath.c_str());
+        throw;
+    }
+}
+
+uint64_t FileHandler::processBuffered(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream) {
+    std::ifstream input(inputPath, std::ios::binary);
+    
+    if (!input) {
+        throw std::runtime_error("Не удалось открыть файл для чтения: " + inputPath);
+    }
+    
+    std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+    
+    if (!output) {
+        throw std::runtime_error("Не удалось открыть файл для записи: " + outputPath);
+    }
+    
+    std::vector<uint8_t> chunk(ASYNC_CHUNK_SIZE);
+    std::vector<uint8_t> result(stream.updateOutputSize(ASYNC_CHUNK_SIZE) + stream.finishOutputSize());
+    uint64_t written = 0;
+    bool last = false;
+    
+    while (!last) {
+        size_t length;
+        {
+            StageStats::Timer timer(StageStats::Read);
+            input.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+            length = static_cast<size_t>(input.gcount());
+            timer.setBytes(length);
+        }
+        
+        if (input.bad()) {
+            throw std::runtime_error("Ошибка при чтении файла: " + inputPath);
+        }
+        
+        last = !input;
+        size_t size;
+        {
+            StageStats::Timer timer(StageStats::Cipher, length);
+            size = stream.update(chunk.data(), length, result.data());
+            
+            if (last) {
+                size += stream.finish(result.data() + size);
+            }
+        }
+        
+        {
+            StageStats::Timer timer(StageStats::Write, size);
+            output.write(reinterpret_cast<const char*>(result.data()), static_cast<std::streamsize>(size));
+        }
+        
+        if (!output) {
+            throw std::runtime_error("Ошибка при записи файла: " + outputPath);
+        }
+        
+        written += size;
+    }
+    
+    return written;
+}
+
+namespace {
+
+// Чтение до заполнения буфера или конца данных (каналы отдают данные частями)
+size_t readFull(int fd, uint8_t* buffer, size_t length) {
+    size_t total = 0;
+    
+    while (total < length) {
+        unsigned part = static_cast<unsigned>(std::min<size_t>(length - total, 1 << 30));
+#ifdef _WIN32
+        int count = _read(fd, buffer + total, part);
+#else
+        ssize_t count = ::read(fd, buffer + total, part);
+#endif
+        
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Ошибка чтения входных данных: ") + std::strerror(errno));
+        }
+        
+        if (count == 0) {
+            break;
+        }
+        
+        total += static_cast<size_t>(count);
+    }
+    
+    return total;
+}
+
+// Запись всего буфера (write может записать только часть)
+void writeFull(int fd, const uint8_t* buffer, size_t length) {
+    size_t total = 0;
+    
+    while (total < length) {
+        unsigned part = static_cast<unsigned>(std::min<size_t>(length - total, 1 << 30));
+#ifdef _WIN32
+        int count = _write(fd, buffer + total, part);
+#else
+        ssize_t count = ::write(fd, buffer + total, part);
+#endif
+        
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Ошибка записи выходных данных: ") + std::strerror(errno));
+        }
+        
+        total += static_cast<size_t>(count);
+    }
+}
+
+} // namespace
+
+uint64_t FileHandler::processDescriptors(int inputFd, int outputFd, ICipherStream& stream, size_t chunkSize) {
+    chunkSize = std::max<size_t>(chunkSize, 1);
+    
+    std::vector<uint8_t> chunk(chunkSize);
+    std::vector<uint8_t> result(stream.updateOutputSize(chunkSize) + stream.finishOutputSize());
+    uint64_t written = 0;
+    bool last = false;
+    
+    while (!last) {
+        size_t length;
+        {
+            StageStats::Timer timer(StageStats::Read);
+            length = readFull(inputFd, chunk.data(), chunkSize);
+            timer.setBytes(length);
+        }
+        last = length < chunkSize;
+        
+        size_t size;
+        {
+            StageStats::Timer timer(StageStats::Cipher, length);
+            size = stream.update(chunk.data(), length, result.data());
+            
+            if (last) {
+                size += stream.finish(result.data() + size);
+            }
+        }
+        
+        {
+            StageStats::Timer timer(StageStats::Write, size);
+            writeFull(outputFd, result.data(), size);
+        }
+        written += size;
+    }
+    
+    return written;
+}
+
+#ifdef RGR_IO_URING
+
+namespace {
+
+// Дескриптор файла с закрытием в деструкторе
+struct FileDescriptor {
+    int fd;
+    
+    explicit FileDescriptor(int descriptor) : fd(descriptor) {}
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+};
+
+// Фрагмент в обработке: чтение -> шифрование -> запись -> свободен
+struct AsyncSlot {
+    enum class State { Free, Reading, Ready, Writing };
+    
+    State state = State::Free;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    uint64_t chunk = 0;
+    size_t expected = 0;
+    size_t done = 0;
+    size_t outputSize = 0;
+    uint64_t outputOffset = 0;
+    
+    // Начало чтения или записи фрагмента (для StageStats: время от отправки до завершения)
+    std::chrono::steady_clock::time_point started;
+};
+
+} // namespace
+
+uint64_t FileHandler::processUring(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream) {
+    // Буферы объявлены раньше кольца: кольцо закрывается до их освобождения
+    std::vector<AsyncSlot> slots(ASYNC_DEPTH);
+    std::vector<IoUring::Buffer> buffers;
+    
+    for (AsyncSlot& slot : slots) {
+        slot.input.resize(ASYNC_CHUNK_SIZE);
+        slot.output.resize(stream.updateOutputSize(ASYNC_CHUNK_SIZE) + stream.finishOutputSize());
+        buffers.push_back({slot.input.data(), slot.input.size()});
+        buffers.push_back({slot.output.data(), slot.output.size()});
+    }
+    
+    // Кольцо и регистрация буферов - до открытия файлов: если io_uring запрещен или
+    // не хватает RLIMIT_MEMLOCK, файл обрабатывается обычным вводом-выводом
+    std::unique_ptr<IoUring> uring;
+    
+    try {
+        uring = std::make_unique<IoUring>(ASYNC_DEPTH * 2);
+        uring->registerBuffers(buffers);
+    } catch (const std::runtime_error&) {
+        uring.reset();
+        slots.clear();
+        return processBuffered(inputPath, outputPath, stream);
+    }
+    
+    IoUring& ring = *uring;
+    FileDescriptor input(::open(inputPath.c_str(), O_RDONLY));
+    
+    if (input.fd < 0) {
+        throw std::runtime_error("Не удалось открыть файл для чтения: " + inputPath);
+    }
+    
+    struct stat info;
+    if (fstat(input.fd, &info) != 0) {
+        throw std::runtime_error("Не удалось получить размер файла: " + inputPath);
+    }
+    uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+    
+    FileDescriptor output(::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    
+    if (output.fd < 0) {
+        throw std::runtime_error("Не удалось открыть файл для записи: " + outputPath);
+    }
+    
+    // Пустой файл - один пустой фрагмент (для finish)
+    uint64_t chunkCount = std::max<uint64_t>(1, (fileSize + ASYNC_CHUNK_SIZE - 1) / ASYNC_CHUNK_SIZE);
+    
+    // userData: номер слота * 2 + (1 для записи); буфер слота i - 2i (вход) и 2i + 1 (выход)
+    uint64_t nextRead = 0;
+    uint64_t nextCipher = 0;
+    uint64_t written = 0;
+    unsigned inFlight = 0;
+    
+    auto submitRead = [&](size_t i) {
+        AsyncSlot& slot = slots[i];
+        ring.prepareRead(input.fd, slot.input.data() + slot.done, static_cast<unsigned>(slot.expected - slot.done),
+                         slot.chunk * ASYNC_CHUNK_SIZE + slot.done, static_cast<unsigned>(i * 2), i * 2);
+        inFlight++;
+    };
+    
+    auto submitWrite = [&](size_t i) {
+        AsyncSlot& slot = slots[i];
+        ring.prepareWrite(output.fd, slot.output.data() + slot.done, static_cast<unsigned>(slot.outputSize - slot.done),
+                          slot.outputOffset + slot.done, static_cast<unsigned>(i * 2 + 1), i * 2 + 1);
+        inFlight++;
+    };
+    
+    try {
+        while (true) {
+            // Свободные слоты получают следующие фрагменты файла
+            for (size_t i = 0; i < slots.size() && nextRead < chunkCount; i++) {
+                AsyncSlot& slot = slots[i];
+                
+                if (slot.state != AsyncSlot::State::Free) {
+                    continue;
+                }
+                
+                slot.chunk = nextRead++;
+                slot.expected = static_cast<size_t>(std::min<uint64_t>(ASYNC_CHUNK_SIZE, fileSize - slot.chunk * ASYNC_CHUNK_SIZE));
+                slot.done = 0;
+                
+                if (slot.expected == 0) {
+                    slot.state = AsyncSlot::State::Ready;
+                } else {
+                    slot.state = AsyncSlot::State::Reading;
+                    if (StageStats::measuring()) {
+                        slot.started = std::chrono::steady_clock::now();
+                    }
+                    submitRead(i);
+                }
+            }
+            
+            // Шифрование строго по порядку фрагментов: состояние потока последовательное
+            for (bool progress = true; progress && nextCipher < chunkCount; ) {
+                progress = false;
+                
+                for (size_t i = 0; i < slots.size(); i++) {
+                    AsyncSlot& slot = slots[i];
+                    
+                    if (slot.state != AsyncSlot::State::Ready || slot.chunk != nextCipher) {
+                        continue;
+                    }
+                    
+                    {
+                        StageStats::Timer timer(StageStats::Cipher, slot.expected);
+                        slot.outputSize = stream.update(slot.input.data(), slot.expected, slot.output.data());
+                        
+                        if (++nextCipher == chunkCount) {
+                            slot.outputSize += stream.finish(slot.output.data() + slot.outputSize);
+                        }
+                    }
+                    
+                    slot.outputOffset = written;
+                    slot.done = 0;
+                    written += slot.outputSize;
+                    
+                    if (slot.outputSize == 0) {
+                        slot.state = AsyncSlot::State::Free;
+                    } else {
+                        slot.state = AsyncSlot::State::Writing;
+                        if (StageStats::measuring()) {
+                            slot.started = std::chrono::steady_clock::now();
+                        }
+                        submitWrite(i);
+                    }
+                    
+                    progress = true;
+                    break;
+                }
+            }
+            
+            if (inFlight == 0) {
+                if (nextCipher == chunkCount) {
+                    break;
+                }
+                continue;
+            }
+            
+            ring.submit(1);
+            
+            uint64_t userData;
+            int result;
+            
+            while (ring.popCompletion(userData, result)) {
+                inFlight--;
+                size_t i = static_cast<size_t>(userData / 2);
+                bool isWrite = (userData & 1) != 0;
+                AsyncSlot& slot = slots[i];
+                
+                if (result < 0) {
+                    throw std::runtime_error(std::string(isWrite ? "Ошибка при записи файла: " : "Ошибка при чтении файла: ") +
+                                             std::strerror(-result));
+                }
+                
+                if (result == 0) {
+                    throw std::runtime_error(isWrite ? "Ошибка при записи файла: " + outputPath
+                                                     : "Файл изменился во время чтения: " + inputPath);
+                }
+                
+                slot.done += static_cast<size_t>(result);
+                
+                // Неполная операция продолжается с места остановки
+                if (isWrite) {
+                    if (slot.done < slot.outputSize) {
+                        submitWrite(i);
+                    } else {
+                        slot.state = AsyncSlot::State::Free;
+                        if (StageStats::measuring()) {
+                            StageStats::record(StageStats::Write, slot.outputSize, slot.started, std::chrono::steady_clock::now());
+                        }
+                    }
+                } else {
+                    if (slot.done < slot.expected) {
+                        submitRead(i);
+                    } else {
+                        slot.state = AsyncSlot::State::Ready;
+                        if (StageStats::measuring()) {
+                            StageStats::record(StageStats::Read, slot.expected, slot.started, std::chrono::steady_clock::now());
+                        }
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        // Буферы нельзя освобождать, пока ядро выполняет операции с ними
+        uint64_t userData;
+        int result;
+        
+        try {
+            while (inFlight > 0) {
+                ring.submit(1);
+                while (ring.popCompletion(userData, result)) {
+                    inFlight--;
+                }
+            }
+        } catch (...) {
+        }
+        
+        throw;
+    }
+    
+    return written;
+}
+
+#else
+
+uint64_t FileHandler::processUring(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream) {
+    return processBuffered(inputPath, outputPath, stream);
+}
+
+#endif
+
 bool FileHandler::createDirectories(const std::string& filepath) {
-    // Упрощенная реализация - создание только одного уровня директории
-    size_t pos = filepath.find_last_of("/\\");
+    // Создание всех недостающих уровней родительского каталога
+    std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
     
-    if (pos == std::string::npos) {
+    if (directory.empty()) {
         return true;
     }
     
-    std::string directory = filepath.substr(0, pos);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
     
-    #ifdef _WIN32
-        return mkdir(directory.c_str()) == 0 || errno == EEXIST;
-    #else
-        return mkdir(directory.c_str(), 0755) == 0 || errno == EEXIST;
-    #endif
-}
\ No newline at end of file
+    return !error && std::filesystem::is_directory(directory, error);
+}
@@ -4,6 +4,47 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "cipher_interface.h"
+
+// Отображение файла в память (RAII). Без mmap (Windows) содержимое читается в буфер
+// и записывается обратно при закрытии
+class MappedFile {
+public:
+    enum class Access {
+        Read,       // чтение существующего файла
+        ReadWrite,  // изменение существующего файла на месте
+        Create      // новый файл заданного размера (прежнее содержимое удаляется)
+    };
+    
+    MappedFile(const std::string& filepath, Access access, uint64_t size = 0);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    uint8_t* data() { return bytes; }
+    const uint8_t* data() const { return bytes; }
+    uint64_t size() const { return length; }
+    
+    // Подсказка ядру: страницы читаются последовательно (упреждающее чтение)
+    void adviseSequential();
+    
+    // Снятие отображения; созданный файл усекается до finalSize байт
+    void close(uint64_t finalSize);
+    void close() { close(length); }
+
+private:
+    std::string path;
+    Access access;
+    uint8_t* bytes = nullptr;
+    uint64_t length = 0;
+    bool active = false;
+#ifdef _WIN32
+    std::vector<uint8_t> buffer;
+#else
+    int descriptor = -1;
+#endif
+};
 
 // Класс для работы с файлами
 class FileHandler {
@@ -11,14 +52,57 @@ public:
     // Чтение файла в байты
     static std::vector<uint8_t> readFile(const std::string& filepath);
     
+    // Чтение фрагмента файла: length байт начиная с offset (меньше, если файл короче)
+    static std::vector<uint8_t> readFileRange(const std::string& filepath, uint64_t offset, size_t length);
+    
+    // Размер файла в байтах
+    static uint64_t getFileSize(const std::string& filepath);
+    
     // Запись байтов в файл
     static bool writeFile(const std::string& filepath, const std::vector<uint8_t>& data);
     
     // Проверка существования файла
     static bool fileExists(const std::string& filepath);
     
-    // Создание директорий для пути
+    // Один и тот же файл (в том числе под разными путями)
+    static bool sameFile(const std::string& first, const std::string& second);
+    
+    // Шифрование через отображение: шифр читает из отображения источника и пишет
+    // в отображение приемника заранее заданного размера. Возвращает размер результата
+    static uint64_t processMapped(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream);
+    
+    // Возможна ли обработка на месте: размер вывода равен размеру ввода (поточные шифры)
+    static bool canProcessInPlace(const ICipherStream& stream);
+    
+    // Шифрование на месте: страницы файла перезаписываются результатом
+    static uint64_t processInPlace(const std::string& filepath, ICipherStream& stream);
+    
+    // Асинхронная обработка: несколько чтений и записей фрагментов фиксированного размера
+    // одновременно в очереди io_uring с зарегистрированными буферами; готовые фрагменты
+    // шифруются по порядку. Без io_uring или при отказе в закреплении буферов -
+    // последовательное чтение и запись фрагментами
+    static uint64_t processAsync(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream);
+    
+    // Доступен ли io_uring вместе с регистрацией буферов (иначе processAsync использует обычный ввод-вывод)
+    static bool asyncIoAvailable();
+    
+    // Потоковая обработка между дескрипторами (например, stdin -> stdout) фрагментами chunkSize байт.
+    // Память ограничена размером фрагмента; возвращает размер результата
+    static uint64_t processDescriptors(int inputFd, int outputFd, ICipherStream& stream, size_t chunkSize);
+    
+    // Создание всех недостающих директорий для пути к файлу
     static bool createDirectories(const std::string& filepath);
+
+private:
+    // Размер фрагмента и число фрагментов в обработке для processAsync
+    static constexpr size_t ASYNC_CHUNK_SIZE = 1 << 20;
+    static constexpr unsigned ASYNC_DEPTH = 8;
+    
+    // Обработка через io_uring
+    static uint64_t processUring(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream);
+    
+    // Последовательная обработка фрагментами через потоки ввода-вывода
+    static uint64_t processBuffered(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream);
 };
 
 #endif
\ No newline at end of file
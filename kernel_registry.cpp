@@ -0,0 +1,223 @@
+#include "../include/kernel_registry.h"
+#include "../include/magma.h"
+#include "../include/chacha20.h"
+#include "../include/trithemius.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+using Level = CpuFeatures::Level;
+
+// Порядок ядер совпадает с перечислениями Kernel в magma_simd.h, chacha20_simd.h, trithemius_simd.h
+const std::vector<KernelRegistry::Kernel> KERNELS[KernelRegistry::ALGORITHM_COUNT] = {
+    {{"scalar", Level::Scalar}, {"ssse3", Level::Ssse3}, {"avx2", Level::Avx2}},
+    {{"scalar", Level::Scalar}, {"sse2", Level::Sse2}, {"avx2", Level::Avx2}, {"avx512", Level::Avx512}},
+    {{"scalar", Level::Scalar}, {"sse2", Level::Sse2}, {"avx2", Level::Avx2}}
+};
+
+const char* const ALGORITHM_NAMES[KernelRegistry::ALGORITHM_COUNT] = {"magma", "chacha20", "trithemius"};
+
+// Результат самопроверки ядра
+enum class Verdict {
+    Unknown,
+    Passed,
+    Failed
+};
+
+// Самопроверка ядра против эталонной реализации шифра
+bool selfTest(KernelRegistry::Algorithm algorithm, int kernel) {
+    switch (algorithm) {
+        case KernelRegistry::Magma:
+            return MagmaCipher::verifyKernel(kernel);
+        case KernelRegistry::ChaCha20:
+            return ChaCha20Cipher::verifyKernel(kernel);
+        default:
+            return TrithemiusCipher::verifyKernel(kernel);
+    }
+}
+
+class Registry {
+public:
+    // Разбор RGR_KERNELS и первый выбор ядер
+    Registry() {
+        for (int a = 0; a < KernelRegistry::ALGORITHM_COUNT; a++) {
+            forced[a] = -1;
+            verdicts[a].assign(KERNELS[a].size(), Verdict::Unknown);
+        }
+        
+        const char* value = std::getenv(KernelRegistry::ENVIRONMENT_VARIABLE);
+        if (value) {
+            parseForced(value);
+        }
+        
+        reselect();
+    }
+    
+    int selected(KernelRegistry::Algorithm algorithm) const {
+        return selection[algorithm].load(std::memory_order_relaxed);
+    }
+    
+    bool usable(KernelRegistry::Algorithm algorithm, int kernel) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return usableLocked(algorithm, kernel);
+    }
+    
+    bool select(KernelRegistry::Algorithm algorithm, int kernel) {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        if (!usableLocked(algorithm, kernel)) {
+            return false;
+        }
+        
+        selection[algorithm].store(kernel, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // Ядро из RGR_KERNELS, если оно пригодно, иначе самое широкое пригодное
+    void reselect() {
+        std::lock_guard<std::mutex> lock(mutex);
+        notes = parseNotes;
+        
+        for (int a = 0; a < KernelRegistry::ALGORITHM_COUNT; a++) {
+            KernelRegistry::Algorithm algorithm = static_cast<KernelRegistry::Algorithm>(a);
+            const std::vector<KernelRegistry::Kernel>& list = KERNELS[a];
+            int choice = 0;
+            
+            for (int k = static_cast<int>(list.size()) - 1; k > 0; k--) {
+                if (!usableLocked(algorithm, k)) {
+                    if (verdicts[a][k] == Verdict::Failed) {
+                        notes.push_back(std::string("ядро ") + list[k].name + " алгоритма " + ALGORITHM_NAMES[a] +
+                                        " не прошло самопроверку и отключено");
+                    }
+                } else if (choice == 0) {
+                    choice = k;
+                }
+            }
+            
+            if (forced[a] >= 0) {
+                if (usableLocked(algorithm, forced[a])) {
+                    choice = forced[a];
+                } else {
+                    notes.push_back(std::string(KernelRegistry::ENVIRONMENT_VARIABLE) + ": ядро " +
+                                    list[forced[a]].name + " алгоритма " + ALGORITHM_NAMES[a] +
+                                    " недоступно, выбрано " + list[choice].name);
+                }
+            }
+            
+            selection[a].store(choice, std::memory_order_relaxed);
+        }
+    }
+    
+    std::vector<std::string> warnings() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return notes;
+    }
+
+private:
+    std::mutex mutex;
+    std::atomic<int> selection[KernelRegistry::ALGORITHM_COUNT];
+    std::vector<Verdict> verdicts[KernelRegistry::ALGORITHM_COUNT];
+    
+    // Ядра из RGR_KERNELS (-1 - автоматический выбор)
+    int forced[KernelRegistry::ALGORITHM_COUNT];
+    
+    // Замечания разбора RGR_KERNELS и последнего выбора
+    std::vector<std::string> parseNotes;
+    std::vector<std::string> notes;
+    
+    // Самопроверка выполняется один раз и только для ядер, которые поддерживает процессор
+    bool usableLocked(KernelRegistry::Algorithm algorithm, int kernel) {
+        if (kernel < 0 || kernel >= static_cast<int>(KERNELS[algorithm].size()) ||
+            !CpuFeatures::supports(KERNELS[algorithm][kernel].level)) {
+            return false;
+        }
+        
+        Verdict& verdict = verdicts[algorithm][kernel];
+        if (verdict == Verdict::Unknown) {
+            verdict = selfTest(algorithm, kernel) ? Verdict::Passed : Verdict::Failed;
+        }
+        
+        return verdict == Verdict::Passed;
+    }
+    
+    // Элементы "алгоритм=ядро" через запятую; ошибочные элементы пропускаются с замечанием
+    void parseForced(const std::string& value) {
+        std::istringstream iss(value);
+        std::string item;
+        
+        while (std::getline(iss, item, ',')) {
+            if (item.empty()) {
+                continue;
+            }
+            
+            size_t equals = item.find('=');
+            int algorithm = -1;
+            int kernel = -1;
+            
+            for (int a = 0; a < KernelRegistry::ALGORITHM_COUNT && equals != std::string::npos; a++) {
+                if (item.compare(0, equals, ALGORITHM_NAMES[a]) != 0) {
+                    continue;
+                }
+                
+                algorithm = a;
+                for (size_t k = 0; k < KERNELS[a].size(); k++) {
+                    if (item.compare(equals + 1, std::string::npos, KERNELS[a][k].name) == 0) {
+                        kernel = static_cast<int>(k);
+                    }
+                }
+            }
+            
+            if (kernel < 0) {
+                parseNotes.push_back(std::string(KernelRegistry::ENVIRONMENT_VARIABLE) +
+                                     ": неизвестный алгоритм или ядро \"" + item + "\"");
+                continue;
+            }
+            
+            forced[algorithm] = kernel;
+        }
+    }
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+}
+
+const char* const KernelRegistry::ENVIRONMENT_VARIABLE = "RGR_KERNELS";
+
+const std::vector<KernelRegistry::Kernel>& KernelRegistry::kernels(Algorithm algorithm) {
+    return KERNELS[algorithm];
+}
+
+int KernelRegistry::selected(Algorithm algorithm) {
+    return registry().selected(algorithm);
+}
+
+const char* KernelRegistry::selectedName(Algorithm algorithm) {
+    return KERNELS[algorithm][selected(algorithm)].name;
+}
+
+bool KernelRegistry::usable(Algorithm algorithm, int kernel) {
+    return registry().usable(algorithm, kernel);
+}
+
+bool KernelRegistry::select(Algorithm algorithm, int kernel) {
+    return registry().select(algorithm, kernel);
+}
+
+void KernelRegistry::reselect() {
+    registry().reselect();
+}
+
+const char* KernelRegistry::algorithmName(Algorithm algorithm) {
+    return ALGORITHM_NAMES[algorithm];
+}
+
+std::vector<std::string> KernelRegistry::warnings() {
+    return registry().warnings();
+}
@@ -0,0 +1,60 @@
+#ifndef KERNEL_REGISTRY_H
+#define KERNEL_REGISTRY_H
+
+#include "cpu_features.h"
+#include <string>
+#include <vector>
+
+// Реестр векторных ядер шифров. При первом обращении (CPUID опрашивается один раз)
+// для каждого алгоритма выбирается самое широкое ядро, которое поддерживает процессор
+// и которое прошло самопроверку против эталонной скалярной реализации
+// (encryptBlock, chachaBlock, encryptByte). Ядро можно задать переменной окружения
+// RGR_KERNELS, например "magma=ssse3,chacha20=avx2,trithemius=scalar"
+class KernelRegistry {
+public:
+    // Алгоритмы с векторными ядрами
+    enum Algorithm {
+        Magma,
+        ChaCha20,
+        Trithemius,
+        ALGORITHM_COUNT
+    };
+    
+    // Описание ядра: индекс в списке совпадает со значением MagmaSimd::Kernel,
+    // ChaCha20Simd::Kernel или TrithemiusSimd::Kernel
+    struct Kernel {
+        const char* name;
+        CpuFeatures::Level level;
+    };
+    
+    // Имя переменной окружения с явным выбором ядер
+    static const char* const ENVIRONMENT_VARIABLE;
+    
+    // Ядра алгоритма по возрастанию ширины, нулевое - скалярное
+    static const std::vector<Kernel>& kernels(Algorithm algorithm);
+    
+    // Индекс выбранного ядра (дешевое чтение на каждый пакет данных)
+    static int selected(Algorithm algorithm);
+    
+    // Имя выбранного ядра
+    static const char* selectedName(Algorithm algorithm);
+    
+    // Пригодность ядра: поддержка процессором (с учетом CpuFeatures::limit) и пройденная самопроверка
+    static bool usable(Algorithm algorithm, int kernel);
+    
+    // Явный выбор ядра; для непригодного ядра возвращается false, выбор не меняется.
+    // Как и CpuFeatures::limit, меняется между вызовами шифров, а не во время обработки
+    static bool select(Algorithm algorithm, int kernel);
+    
+    // Повторный автоматический выбор с учетом RGR_KERNELS (например, после CpuFeatures::limit)
+    static void reselect();
+    
+    // Имя алгоритма в RGR_KERNELS и отчетах
+    static const char* algorithmName(Algorithm algorithm);
+    
+    // Замечания последнего выбора: ошибки в RGR_KERNELS, непригодные заданные ядра,
+    // проваленные самопроверки
+    static std::vector<std::string> warnings();
+};
+
+#endif
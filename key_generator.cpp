@@ -31,6 +31,28 @@ std::string KeyGenerator::generateMagmaKey() {
     return oss.str();
 }
 
+std::string KeyGenerator::generateMagmaCtrKey() {
+    std::ostringstream oss;
+    
+    // Генерация 72 hex символов (32 байта ключ + 4 байта синхропосылки)
+    for (int i = 0; i < 72; i++) {
+        oss << randomHexChar();
+    }
+    
+    return oss.str();
+}
+
+std::string KeyGenerator::generateMagmaCbcKey() {
+    std::ostringstream oss;
+    
+    // Генерация 80 hex символов (32 байта ключ + 8 байт синхропосылки)
+    for (int i = 0; i < 80; i++) {
+        oss << randomHexChar();
+    }
+    
+    return oss.str();
+}
+
 std::string KeyGenerator::generateTrithemiusKey() {
     // Генерация трех случайных чисел
     int a = randomInt(1, 10);
@@ -51,5 +73,27 @@ std::string KeyGenerator::generateChaCha20Key() {
         oss << randomHexChar();
     }
     
+    return oss.str();
+}
+
+std::string KeyGenerator::generateChaCha20Counter64Key() {
+    std::ostringstream oss;
+    
+    // Генерация 80 hex символов (32 байта ключ + 8 байт nonce)
+    for (int i = 0; i < 80; i++) {
+        oss << randomHexChar();
+    }
+    
+    return oss.str();
+}
+
+std::string KeyGenerator::generateXChaCha20Key() {
+    std::ostringstream oss;
+    
+    // Генерация 112 hex символов (32 байта ключ + 24 байта nonce)
+    for (int i = 0; i < 112; i++) {
+        oss << randomHexChar();
+    }
+    
     return oss.str();
 }
\ No newline at end of file
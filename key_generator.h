@@ -9,12 +9,24 @@ public:
     // Генерация ключа для Магма (64 hex символа)
     static std::string generateMagmaKey();
     
+    // Генерация ключа с синхропосылкой для Магма в режиме CTR (72 hex символа)
+    static std::string generateMagmaCtrKey();
+    
+    // Генерация ключа с синхропосылкой для Магма в режиме CBC (80 hex символов)
+    static std::string generateMagmaCbcKey();
+    
     // Генерация ключа для Тритемиуса (a,b,c)
     static std::string generateTrithemiusKey();
     
     // Генерация ключа для ChaCha20 (88 hex символов)
     static std::string generateChaCha20Key();
     
+    // Генерация ключа для ChaCha20 с 64-битным счетчиком (80 hex символов)
+    static std::string generateChaCha20Counter64Key();
+    
+    // Генерация ключа для XChaCha20 (112 hex символов)
+    static std::string generateXChaCha20Key();
+    
 private:
     // Генерация случайного hex символа
     static char randomHexChar();
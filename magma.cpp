@@ -1,10 +1,56 @@
 #include "../include/magma.h"
+#include "../include/magma_simd.h"
+#include "../include/kernel_registry.h"
+#include "../include/thread_pool.h"
+#include "../include/trace_log.h"
 #include <stdexcept>
-#include <sstream>
-#include <iomanip>
 #include <cstring>
 #include <algorithm>
 
+namespace {
+
+// Число блоков во фрагменте параллельной обработки (64 КиБ): меньшие объемы выгоднее обработать в одном потоке
+const size_t PARALLEL_CHUNK_BLOCKS = 8192;
+
+// Число блоков гаммы, вырабатываемых за один проход (буфер на стеке)
+const size_t CTR_BATCH = 512;
+
+// Число блоков самопроверки ядер: кратно ширине всех векторных ядер
+const size_t SELF_TEST_BLOCKS = 16;
+
+// Размер фрагмента при шифровании с имитовставкой: фрагмент остается в кэше
+// между шифрованием и выработкой имитовставки
+const size_t MAC_CHUNK = 16384;
+
+// Сдвиг блока влево на 1 бит с приведением по модулю многочлена (B = 0x1B для n = 64)
+void macShiftKey(const uint8_t* input, uint8_t* output) {
+    bool carry = (input[0] & 0x80) != 0;
+    
+    for (int i = 0; i < 7; i++) {
+        output[i] = static_cast<uint8_t>((input[i] << 1) | (input[i + 1] >> 7));
+    }
+    output[7] = static_cast<uint8_t>(input[7] << 1);
+    
+    if (carry) {
+        output[7] ^= 0x1B;
+    }
+}
+
+// Разбиение диапазона блоков [0, blocks) на фрагменты для общего пула потоков
+template <typename Func>
+void parallelBlocks(size_t blocks, Func func) {
+    ThreadPool::shared().parallelRange(blocks, PARALLEL_CHUNK_BLOCKS, func);
+}
+
+// Интервал ядра на временной шкале трассировки
+class KernelSpan : public TraceLog::Span {
+public:
+    explicit KernelSpan(size_t bytes)
+        : TraceLog::Span("magma", "kernel", bytes, KernelRegistry::selectedName(KernelRegistry::Magma)) {}
+};
+
+}
+
 // S-box из RFC 8891 (id-tc26-gost-28147-param-Z)
 const uint8_t MagmaCipher::SBOX[8][16] = {
     {12, 4, 6, 2, 10, 5, 11, 9, 14, 8, 13, 7, 0, 3, 15, 1},
@@ -119,7 +165,422 @@ void MagmaCipher::decryptBlock(const uint8_t* input, uint8_t* output, const std:
     output[7] = (left >> 24) & 0xFF;
 }
 
-std::vector<uint8_t> MagmaCipher::keyToBytes(const std::string& key) {
+const MagmaCipher::RoundTables& MagmaCipher::roundTables() {
+    // Таблицы строятся один раз при первом обращении
+    static const RoundTables tables = [] {
+        RoundTables t;
+        
+        for (int j = 0; j < 4; j++) {
+            for (int b = 0; b < 256; b++) {
+                // Байт j слова содержит полубайты 2j (младший) и 2j+1 (старший)
+                uint32_t substituted = static_cast<uint32_t>(SBOX[2 * j][b & 0x0F]) |
+                                       (static_cast<uint32_t>(SBOX[2 * j + 1][b >> 4]) << 4);
+                substituted <<= j * 8;
+                t[j][b] = (substituted << 11) | (substituted >> 21);
+            }
+        }
+        
+        return t;
+    }();
+    
+    return tables;
+}
+
+uint32_t MagmaCipher::gTransformTable(uint32_t half, uint32_t key, const RoundTables& tables) {
+    uint32_t sum = half + key;
+    return tables[0][sum & 0xFF] ^
+           tables[1][(sum >> 8) & 0xFF] ^
+           tables[2][(sum >> 16) & 0xFF] ^
+           tables[3][sum >> 24];
+}
+
+void MagmaCipher::encryptBlockTable(const uint8_t* input, uint8_t* output, const std::array<uint32_t, 8>& subkeys) {
+    const RoundTables& tables = roundTables();
+    
+    uint32_t left = static_cast<uint32_t>(input[0]) |
+                    (static_cast<uint32_t>(input[1]) << 8) |
+                    (static_cast<uint32_t>(input[2]) << 16) |
+                    (static_cast<uint32_t>(input[3]) << 24);
+    
+    uint32_t right = static_cast<uint32_t>(input[4]) |
+                     (static_cast<uint32_t>(input[5]) << 8) |
+                     (static_cast<uint32_t>(input[6]) << 16) |
+                     (static_cast<uint32_t>(input[7]) << 24);
+    
+    // 24 раунда с прямым порядком ключей
+    for (int i = 0; i < 24; i++) {
+        uint32_t temp = left ^ gTransformTable(right, subkeys[i % 8], tables);
+        left = right;
+        right = temp;
+    }
+    
+    // 8 раундов с обратным порядком ключей
+    for (int i = 0; i < 8; i++) {
+        uint32_t temp = left ^ gTransformTable(right, subkeys[7 - i], tables);
+        left = right;
+        right = temp;
+    }
+    
+    // Запись результата
+    output[0] = right & 0xFF;
+    output[1] = (right >> 8) & 0xFF;
+    output[2] = (right >> 16) & 0xFF;
+    output[3] = (right >> 24) & 0xFF;
+    output[4] = left & 0xFF;
+    output[5] = (left >> 8) & 0xFF;
+    output[6] = (left >> 16) & 0xFF;
+    output[7] = (left >> 24) & 0xFF;
+}
+
+void MagmaCipher::decryptBlockTable(const uint8_t* input, uint8_t* output, const std::array<uint32_t, 8>& subkeys) {
+    const RoundTables& tables = roundTables();
+    
+    uint32_t left = static_cast<uint32_t>(input[0]) |
+                    (static_cast<uint32_t>(input[1]) << 8) |
+                    (static_cast<uint32_t>(input[2]) << 16) |
+                    (static_cast<uint32_t>(input[3]) << 24);
+    
+    uint32_t right = static_cast<uint32_t>(input[4]) |
+                     (static_cast<uint32_t>(input[5]) << 8) |
+                     (static_cast<uint32_t>(input[6]) << 16) |
+                     (static_cast<uint32_t>(input[7]) << 24);
+    
+    // 8 раундов с прямым порядком ключей
+    for (int i = 0; i < 8; i++) {
+        uint32_t temp = left ^ gTransformTable(right, subkeys[i], tables);
+        left = right;
+        right = temp;
+    }
+    
+    // 24 раунда с обратным порядком ключей
+    for (int i = 0; i < 24; i++) {
+        uint32_t temp = left ^ gTransformTable(right, subkeys[7 - (i % 8)], tables);
+        left = right;
+        right = temp;
+    }
+    
+    // Запись результата
+    output[0] = right & 0xFF;
+    output[1] = (right >> 8) & 0xFF;
+    output[2] = (right >> 16) & 0xFF;
+    output[3] = (right >> 24) & 0xFF;
+    output[4] = left & 0xFF;
+    output[5] = (left >> 8) & 0xFF;
+    output[6] = (left >> 16) & 0xFF;
+    output[7] = (left >> 24) & 0xFF;
+}
+
+std::array<uint32_t, MagmaCipher::ROUNDS> MagmaCipher::roundKeySchedule(const std::array<uint32_t, 8>& subkeys, bool decrypt) {
+    std::array<uint32_t, ROUNDS> schedule;
+    
+    for (int i = 0; i < ROUNDS; i++) {
+        if (decrypt) {
+            // 8 раундов с прямым порядком, затем 24 с обратным
+            schedule[i] = i < 8 ? subkeys[i] : subkeys[7 - (i % 8)];
+        } else {
+            // 24 раунда с прямым порядком, затем 8 с обратным
+            schedule[i] = i < 24 ? subkeys[i % 8] : subkeys[7 - (i % 8)];
+        }
+    }
+    
+    return schedule;
+}
+
+void MagmaCipher::processBlocks(const uint8_t* input, uint8_t* output, size_t blocks,
+                                const std::array<uint32_t, 8>& subkeys, bool decrypt) {
+    size_t done = 0;
+    int kernel = KernelRegistry::selected(KernelRegistry::Magma);
+    
+    if (kernel != MagmaSimd::Scalar) {
+        done = MagmaSimd::processBlocks(kernel, input, output, blocks, roundKeySchedule(subkeys, decrypt), SBOX);
+    }
+    
+    // Оставшиеся блоки (или все, если векторных ядер нет)
+    for (size_t i = done; i < blocks; i++) {
+        if (decrypt) {
+            decryptBlockTable(input + i * BLOCK_SIZE, output + i * BLOCK_SIZE, subkeys);
+        } else {
+            encryptBlockTable(input + i * BLOCK_SIZE, output + i * BLOCK_SIZE, subkeys);
+        }
+    }
+}
+
+bool MagmaCipher::verifyKernel(int kernel) {
+    MagmaCipher reference;
+    
+    std::vector<uint8_t> key(KEY_SIZE);
+    for (int i = 0; i < KEY_SIZE; i++) {
+        key[i] = static_cast<uint8_t>(0xFF - i * 17);
+    }
+    std::array<uint32_t, 8> subkeys = expandKey(key);
+    
+    uint8_t plain[SELF_TEST_BLOCKS * BLOCK_SIZE];
+    uint8_t expected[SELF_TEST_BLOCKS * BLOCK_SIZE];
+    uint8_t encrypted[SELF_TEST_BLOCKS * BLOCK_SIZE];
+    uint8_t decrypted[SELF_TEST_BLOCKS * BLOCK_SIZE];
+    
+    for (size_t i = 0; i < sizeof(plain); i++) {
+        plain[i] = static_cast<uint8_t>(i * 151 + 3);
+    }
+    
+    // Эталон - побитовая реализация раунда
+    for (size_t i = 0; i < SELF_TEST_BLOCKS; i++) {
+        reference.encryptBlock(plain + i * BLOCK_SIZE, expected + i * BLOCK_SIZE, subkeys);
+    }
+    
+    size_t encryptedBlocks = SELF_TEST_BLOCKS;
+    size_t decryptedBlocks = SELF_TEST_BLOCKS;
+    
+    if (kernel == MagmaSimd::Scalar) {
+        for (size_t i = 0; i < SELF_TEST_BLOCKS; i++) {
+            reference.encryptBlockTable(plain + i * BLOCK_SIZE, encrypted + i * BLOCK_SIZE, subkeys);
+            reference.decryptBlockTable(expected + i * BLOCK_SIZE, decrypted + i * BLOCK_SIZE, subkeys);
+        }
+    } else {
+        encryptedBlocks = MagmaSimd::processBlocks(kernel, plain, encrypted, SELF_TEST_BLOCKS,
+                                                   roundKeySchedule(subkeys, false), SBOX);
+        decryptedBlocks = MagmaSimd::processBlocks(kernel, expected, decrypted, SELF_TEST_BLOCKS,
+                                                   roundKeySchedule(subkeys, true), SBOX);
+    }
+    
+    return encryptedBlocks == SELF_TEST_BLOCKS && decryptedBlocks == SELF_TEST_BLOCKS &&
+           std::memcmp(encrypted, expected, sizeof(expected)) == 0 &&
+           std::memcmp(decrypted, plain, sizeof(plain)) == 0;
+}
+
+void MagmaCipher::processEcb(const uint8_t* input, uint8_t* output, size_t blocks,
+                             const std::array<uint32_t, 8>& subkeys, bool decrypt) {
+    parallelBlocks(blocks, [&](size_t begin, size_t end) {
+        KernelSpan span((end - begin) * BLOCK_SIZE);
+        processBlocks(input + begin * BLOCK_SIZE, output + begin * BLOCK_SIZE, end - begin, subkeys, decrypt);
+    });
+}
+
+void MagmaCipher::ctrBlock(uint32_t iv, uint64_t index, uint8_t* output) {
+    uint64_t counter = (static_cast<uint64_t>(iv) << 32) + index;
+    
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        output[i] = static_cast<uint8_t>(counter >> (56 - i * 8));
+    }
+}
+
+void MagmaCipher::processCtr(const uint8_t* input, uint8_t* output, size_t length,
+                             const std::array<uint32_t, 8>& subkeys, uint32_t iv, uint64_t offset) {
+    uint64_t firstBlock = offset / BLOCK_SIZE;
+    size_t phase = static_cast<size_t>(offset % BLOCK_SIZE);
+    size_t pos = 0;
+    uint8_t counter[BLOCK_SIZE];
+    uint8_t gamma[BLOCK_SIZE];
+    
+    // Неполный первый блок, если смещение не выровнено
+    if (phase != 0 && length > 0) {
+        ctrBlock(iv, firstBlock, counter);
+        encryptBlockTable(counter, gamma, subkeys);
+        
+        for (; pos < length && phase + pos < BLOCK_SIZE; pos++) {
+            output[pos] = input[pos] ^ gamma[phase + pos];
+        }
+        
+        firstBlock++;
+    }
+    
+    // Полные блоки: гамма вырабатывается пакетами и обрабатывается параллельно
+    size_t fullBlocks = (length - pos) / BLOCK_SIZE;
+    const uint8_t* in = input + pos;
+    uint8_t* out = output + pos;
+    
+    parallelBlocks(fullBlocks, [&](size_t begin, size_t end) {
+        KernelSpan span((end - begin) * BLOCK_SIZE);
+        uint8_t counters[CTR_BATCH * BLOCK_SIZE];
+        uint8_t stream[CTR_BATCH * BLOCK_SIZE];
+        
+        for (size_t block = begin; block < end; block += CTR_BATCH) {
+            size_t count = std::min(CTR_BATCH, end - block);
+            
+            for (size_t i = 0; i < count; i++) {
+                ctrBlock(iv, firstBlock + block + i, &counters[i * BLOCK_SIZE]);
+            }
+            
+            processBlocks(counters, stream, count, subkeys, false);
+            
+            for (size_t i = 0; i < count * BLOCK_SIZE; i++) {
+                out[block * BLOCK_SIZE + i] = in[block * BLOCK_SIZE + i] ^ stream[i];
+            }
+        }
+    });
+    
+    pos += fullBlocks * BLOCK_SIZE;
+    
+    // Неполный последний блок
+    if (pos < length) {
+        ctrBlock(iv, firstBlock + fullBlocks, counter);
+        encryptBlockTable(counter, gamma, subkeys);
+        
+        for (size_t i = 0; pos < length; i++, pos++) {
+            output[pos] = input[pos] ^ gamma[i];
+        }
+    }
+}
+
+void MagmaCipher::encryptCbc(const uint8_t* input, uint8_t* output, size_t blocks,
+                             const std::array<uint32_t, 8>& subkeys, const uint8_t* iv) {
+    KernelSpan span(blocks * BLOCK_SIZE);
+    const uint8_t* previous = iv;
+    uint8_t buffer[BLOCK_SIZE];
+    
+    for (size_t i = 0; i < blocks; i++) {
+        for (int j = 0; j < BLOCK_SIZE; j++) {
+            buffer[j] = input[i * BLOCK_SIZE + j] ^ previous[j];
+        }
+        
+        encryptBlockTable(buffer, &output[i * BLOCK_SIZE], subkeys);
+        previous = &output[i * BLOCK_SIZE];
+    }
+}
+
+void MagmaCipher::decryptCbc(const uint8_t* input, uint8_t* output, size_t blocks,
+                             const std::array<uint32_t, 8>& subkeys, const uint8_t* iv) {
+    // На месте (output == input) последний блок шифртекста фрагмента может быть перезаписан
+    // раньше, чем его прочитает следующий фрагмент: граничные блоки сохраняются заранее
+    std::vector<uint8_t> boundaries;
+    if (input == output && blocks > PARALLEL_CHUNK_BLOCKS) {
+        for (size_t begin = PARALLEL_CHUNK_BLOCKS; begin < blocks; begin += PARALLEL_CHUNK_BLOCKS) {
+            boundaries.insert(boundaries.end(), &input[(begin - 1) * BLOCK_SIZE], &input[begin * BLOCK_SIZE]);
+        }
+    }
+    
+    parallelBlocks(blocks, [&](size_t begin, size_t end) {
+        KernelSpan span((end - begin) * BLOCK_SIZE);
+        uint8_t previous[BLOCK_SIZE];
+        uint8_t cipherText[CTR_BATCH * BLOCK_SIZE];
+        
+        if (begin == 0) {
+            std::memcpy(previous, iv, BLOCK_SIZE);
+        } else if (!boundaries.empty()) {
+            std::memcpy(previous, &boundaries[(begin / PARALLEL_CHUNK_BLOCKS - 1) * BLOCK_SIZE], BLOCK_SIZE);
+        } else {
+            std::memcpy(previous, &input[(begin - 1) * BLOCK_SIZE], BLOCK_SIZE);
+        }
+        
+        // Пакет шифртекста копируется до расшифрования: он нужен для зацепления
+        for (size_t block = begin; block < end; block += CTR_BATCH) {
+            size_t count = std::min(CTR_BATCH, end - block);
+            uint8_t* out = &output[block * BLOCK_SIZE];
+            
+            std::memcpy(cipherText, &input[block * BLOCK_SIZE], count * BLOCK_SIZE);
+            processBlocks(cipherText, out, count, subkeys, true);
+            
+            // P_i = D(C_i) xor C_(i-1), где C_(-1) = IV
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t* chain = i == 0 ? previous : &cipherText[(i - 1) * BLOCK_SIZE];
+                
+                for (int j = 0; j < BLOCK_SIZE; j++) {
+                    out[i * BLOCK_SIZE + j] ^= chain[j];
+                }
+            }
+            
+            std::memcpy(previous, &cipherText[(count - 1) * BLOCK_SIZE], BLOCK_SIZE);
+        }
+    });
+}
+
+int MagmaCipher::ivSize() const {
+    switch (mode) {
+        case Mode::CTR:
+            return CTR_IV_SIZE;
+        case Mode::CBC:
+            return CBC_IV_SIZE;
+        default:
+            return 0;
+    }
+}
+
+void MagmaCipher::processChunk(const uint8_t* input, uint8_t* output, size_t offset, size_t length,
+                               const Key& key, bool decrypt, const uint8_t* previousBlock) {
+    switch (mode) {
+        case Mode::CTR:
+            processCtr(input, output, length, key.subkeys, key.ctrIv, offset);
+            break;
+        case Mode::CBC:
+            if (decrypt) {
+                decryptCbc(input, output, length / BLOCK_SIZE, key.subkeys, previousBlock);
+            } else {
+                encryptCbc(input, output, length / BLOCK_SIZE, key.subkeys, previousBlock);
+            }
+            break;
+        default:
+            processEcb(input, output, length / BLOCK_SIZE, key.subkeys, decrypt);
+            break;
+    }
+}
+
+void MagmaCipher::macInit(MacContext& ctx, const std::array<uint32_t, 8>& macSubkeys) {
+    ctx.subkeys = macSubkeys;
+    
+    // R = E(0^64), K1 = R << 1 (mod), K2 = K1 << 1 (mod)
+    uint8_t zero[BLOCK_SIZE] = {0};
+    uint8_t r[BLOCK_SIZE];
+    encryptBlockTable(zero, r, ctx.subkeys);
+    macShiftKey(r, ctx.k1);
+    macShiftKey(ctx.k1, ctx.k2);
+    
+    std::memset(ctx.state, 0, BLOCK_SIZE);
+    ctx.pendingSize = 0;
+}
+
+void MagmaCipher::macUpdate(MacContext& ctx, const uint8_t* data, size_t length) {
+    uint8_t buffer[BLOCK_SIZE];
+    
+    while (length > 0) {
+        // Накопленный полный блок обрабатывается, только если за ним есть еще данные
+        if (ctx.pendingSize == BLOCK_SIZE) {
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                buffer[i] = ctx.state[i] ^ ctx.pending[i];
+            }
+            encryptBlockTable(buffer, ctx.state, ctx.subkeys);
+            ctx.pendingSize = 0;
+        }
+        
+        size_t take = std::min(length, static_cast<size_t>(BLOCK_SIZE) - ctx.pendingSize);
+        std::memcpy(ctx.pending + ctx.pendingSize, data, take);
+        ctx.pendingSize += take;
+        data += take;
+        length -= take;
+    }
+}
+
+void MagmaCipher::macFinal(MacContext& ctx, uint8_t* tag) {
+    uint8_t buffer[BLOCK_SIZE];
+    const uint8_t* finalKey = ctx.k1;
+    
+    // Неполный (или пустой) последний блок дополняется 1 0...0 и маскируется K2
+    if (ctx.pendingSize < BLOCK_SIZE) {
+        ctx.pending[ctx.pendingSize] = 0x80;
+        std::memset(ctx.pending + ctx.pendingSize + 1, 0, BLOCK_SIZE - ctx.pendingSize - 1);
+        finalKey = ctx.k2;
+    }
+    
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        buffer[i] = ctx.state[i] ^ ctx.pending[i] ^ finalKey[i];
+    }
+    
+    encryptBlockTable(buffer, tag, ctx.subkeys);
+}
+
+size_t MagmaCipher::paddingSize(const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    
+    uint8_t padding = data[length - 1];
+    return padding > 0 && padding <= BLOCK_SIZE && padding <= length ? padding : 0;
+}
+
+void MagmaCipher::removePadding(std::vector<uint8_t>& data) {
+    data.resize(data.size() - paddingSize(data.data(), data.size()));
+}
+
+std::vector<uint8_t> MagmaCipher::keyToBytes(const std::string& key) const {
     std::vector<uint8_t> bytes;
     
     for (size_t i = 0; i < key.length(); i += 2) {
@@ -131,8 +592,79 @@ std::vector<uint8_t> MagmaCipher::keyToBytes(const std::string& key) {
     return bytes;
 }
 
+PreparedKeyPtr MagmaCipher::prepareKey(const std::string& key) const {
+    if (!validateKey(key)) {
+        throw std::invalid_argument("Неверный формат ключа для Магма");
+    }
+    
+    std::vector<uint8_t> keyBytes = keyToBytes(key);
+    auto prepared = std::make_shared<Key>();
+    
+    prepared->mode = mode;
+    prepared->subkeys = expandKey(keyBytes);
+    std::memset(prepared->iv, 0, CBC_IV_SIZE);
+    std::memcpy(prepared->iv, keyBytes.data() + KEY_SIZE, keyBytes.size() - KEY_SIZE);
+    
+    // Синхропосылка CTR следует за ключом, старший байт первым
+    prepared->ctrIv = (static_cast<uint32_t>(prepared->iv[0]) << 24) |
+                      (static_cast<uint32_t>(prepared->iv[1]) << 16) |
+                      (static_cast<uint32_t>(prepared->iv[2]) << 8) |
+                      static_cast<uint32_t>(prepared->iv[3]);
+    
+    return prepared;
+}
+
+PreparedKeyPtr MagmaCipher::prepareMacKey(const std::string& macKey) const {
+    if (!validateMacKey(macKey)) {
+        throw std::invalid_argument("Ключ имитовставки должен содержать 64 hex символа");
+    }
+    
+    auto prepared = std::make_shared<Key>();
+    prepared->mode = Mode::ECB;
+    prepared->subkeys = expandKey(keyToBytes(macKey));
+    std::memset(prepared->iv, 0, CBC_IV_SIZE);
+    prepared->ctrIv = 0;
+    
+    return prepared;
+}
+
+const MagmaCipher::Key& MagmaCipher::preparedKey(const PreparedKey& key) const {
+    const Key* prepared = dynamic_cast<const Key*>(&key);
+    
+    if (!prepared) {
+        throw std::invalid_argument("Ключ подготовлен не для алгоритма Магма");
+    }
+    
+    if (prepared->mode != mode) {
+        throw std::invalid_argument("Ключ Магмы подготовлен для другого режима работы");
+    }
+    
+    return *prepared;
+}
+
+const MagmaCipher::Key& MagmaCipher::preparedMacKey(const PreparedKey& macKey) {
+    const Key* prepared = dynamic_cast<const Key*>(&macKey);
+    
+    if (!prepared) {
+        throw std::invalid_argument("Ключ имитовставки подготовлен не для алгоритма Магма");
+    }
+    
+    return *prepared;
+}
+
+std::string MagmaCipher::getKeyFormat() const {
+    switch (mode) {
+        case Mode::CTR:
+            return "72 шестнадцатеричных символа: 64 для ключа + 8 для синхропосылки";
+        case Mode::CBC:
+            return "80 шестнадцатеричных символов: 64 для ключа + 16 для синхропосылки";
+        default:
+            return "64 шестнадцатеричных символа (32 байта)";
+    }
+}
+
 bool MagmaCipher::validateKey(const std::string& key) const {
-    if (key.length() != 64) return false;
+    if (key.length() != static_cast<size_t>((KEY_SIZE + ivSize()) * 2)) return false;
     
     for (char c : key) {
         if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
@@ -142,84 +674,397 @@ bool MagmaCipher::validateKey(const std::string& key) const {
 }
 
 std::vector<uint8_t> MagmaCipher::encryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
-    if (!validateKey(key)) {
-        throw std::invalid_argument("Неверный формат ключа для Магма");
-    }
+    return encryptBytes(data, *prepareKey(key));
+}
+
+std::vector<uint8_t> MagmaCipher::encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) {
+    std::vector<uint8_t> result(encryptedSize(data.size()));
+    result.resize(encryptBytes(data.data(), data.size(), result.data(), key));
+    return result;
+}
+
+size_t MagmaCipher::encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) {
+    const Key& prepared = preparedKey(key);
+    const auto& subkeys = prepared.subkeys;
     
-    std::vector<uint8_t> keyBytes = keyToBytes(key);
-    auto subkeys = expandKey(keyBytes);
+    // Гаммирование не требует дополнения
+    if (mode == Mode::CTR) {
+        processCtr(input, output, length, subkeys, prepared.ctrIv, 0);
+        return length;
+    }
     
-    // Добавление padding (PKCS7)
-    size_t paddingSize = BLOCK_SIZE - (data.size() % BLOCK_SIZE);
-    std::vector<uint8_t> paddedData = data;
-    for (size_t i = 0; i < paddingSize; i++) {
-        paddedData.push_back(static_cast<uint8_t>(paddingSize));
+    // Дополнение (PKCS7) собирается только в последнем блоке, без копии входных данных.
+    // Хвост копируется до записи результата, поэтому допускается output == input
+    size_t fullBlocks = length / BLOCK_SIZE;
+    size_t tail = length % BLOCK_SIZE;
+    uint8_t lastBlock[BLOCK_SIZE];
+    if (tail != 0) {
+        std::memcpy(lastBlock, input + fullBlocks * BLOCK_SIZE, tail);
     }
+    std::memset(lastBlock + tail, static_cast<int>(BLOCK_SIZE - tail), BLOCK_SIZE - tail);
     
-    std::vector<uint8_t> result;
-    result.resize(paddedData.size());
+    uint8_t* last = output + fullBlocks * BLOCK_SIZE;
     
-    // Шифрование блоками
-    for (size_t i = 0; i < paddedData.size(); i += BLOCK_SIZE) {
-        encryptBlock(&paddedData[i], &result[i], subkeys);
+    if (mode == Mode::CBC) {
+        // Шифрование с зацеплением (каждый блок зависит от предыдущего)
+        encryptCbc(input, output, fullBlocks, subkeys, prepared.iv);
+        const uint8_t* previous = fullBlocks == 0 ? prepared.iv : last - BLOCK_SIZE;
+        encryptCbc(lastBlock, last, 1, subkeys, previous);
+    } else {
+        // Шифрование блоками (режим простой замены, блоки независимы, обрабатываются параллельно)
+        processEcb(input, output, fullBlocks, subkeys, false);
+        processBlocks(lastBlock, last, 1, subkeys, false);
     }
     
-    return result;
+    return (fullBlocks + 1) * BLOCK_SIZE;
 }
 
 std::vector<uint8_t> MagmaCipher::decryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
-    if (!validateKey(key)) {
-        throw std::invalid_argument("Неверный формат ключа для Магма");
+    return decryptBytes(data, *prepareKey(key));
+}
+
+std::vector<uint8_t> MagmaCipher::decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) {
+    std::vector<uint8_t> result(decryptedSize(data.size()));
+    result.resize(decryptBytes(data.data(), data.size(), result.data(), key));
+    return result;
+}
+
+size_t MagmaCipher::decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) {
+    const Key& prepared = preparedKey(key);
+    
+    // Гаммирование симметрично - шифрование = дешифрование
+    if (mode == Mode::CTR) {
+        return encryptBytes(input, length, output, key);
     }
     
-    if (data.size() % BLOCK_SIZE != 0) {
+    if (length % BLOCK_SIZE != 0) {
         throw std::invalid_argument("Размер зашифрованных данных должен быть кратен 8 байтам");
     }
     
-    std::vector<uint8_t> keyBytes = keyToBytes(key);
-    auto subkeys = expandKey(keyBytes);
-    
-    std::vector<uint8_t> result;
-    result.resize(data.size());
+    const auto& subkeys = prepared.subkeys;
     
-    // Дешифрование блоками
-    for (size_t i = 0; i < data.size(); i += BLOCK_SIZE) {
-        decryptBlock(&data[i], &result[i], subkeys);
+    if (mode == Mode::CBC) {
+        // Дешифрование с зацеплением: все блоки расшифровываются независимо и параллельно
+        decryptCbc(input, output, length / BLOCK_SIZE, subkeys, prepared.iv);
+    } else {
+        // Дешифрование блоками (режим простой замены, блоки независимы, обрабатываются параллельно)
+        processEcb(input, output, length / BLOCK_SIZE, subkeys, true);
     }
     
     // Удаление padding
-    if (!result.empty()) {
-        uint8_t paddingSize = result.back();
-        if (paddingSize > 0 && paddingSize <= BLOCK_SIZE && paddingSize <= result.size()) {
-            result.resize(result.size() - paddingSize);
+    return length - paddingSize(output, length);
+}
+
+size_t MagmaCipher::encryptedSize(size_t length) const {
+    return mode == Mode::CTR ? length : (length / BLOCK_SIZE + 1) * BLOCK_SIZE;
+}
+
+size_t MagmaCipher::decryptedSize(size_t length) const {
+    return length;
+}
+
+std::vector<uint8_t> MagmaCipher::cryptAt(const std::vector<uint8_t>& data, const std::string& key, uint64_t offset) {
+    if (mode != Mode::CTR) {
+        throw std::logic_error("Произвольный доступ поддерживается только в режиме гаммирования");
+    }
+    
+    return cryptAt(data, *prepareKey(key), offset);
+}
+
+std::vector<uint8_t> MagmaCipher::cryptAt(const std::vector<uint8_t>& data, const PreparedKey& key, uint64_t offset) {
+    if (mode != Mode::CTR) {
+        throw std::logic_error("Произвольный доступ поддерживается только в режиме гаммирования");
+    }
+    
+    const Key& prepared = preparedKey(key);
+    
+    std::vector<uint8_t> result(data.size());
+    processCtr(data.data(), result.data(), data.size(), prepared.subkeys, prepared.ctrIv, offset);
+    
+    return result;
+}
+
+bool MagmaCipher::validateMacKey(const std::string& macKey) {
+    if (macKey.length() != KEY_SIZE * 2) return false;
+    
+    for (char c : macKey) {
+        if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+    }
+    
+    return true;
+}
+
+std::vector<uint8_t> MagmaCipher::encryptWithMac(const std::vector<uint8_t>& data, const std::string& key,
+                                                 const std::string& macKey) {
+    PreparedKeyPtr prepared = prepareKey(key);
+    return encryptWithMac(data, *prepared, *prepareMacKey(macKey));
+}
+
+std::vector<uint8_t> MagmaCipher::encryptWithMac(const std::vector<uint8_t>& data, const PreparedKey& key,
+                                                 const PreparedKey& macKey) {
+    const Key& prepared = preparedKey(key);
+    
+    MacContext mac;
+    macInit(mac, preparedMacKey(macKey).subkeys);
+    
+    // Дополнение нужно только блочным режимам: полные блоки шифруются прямо из data,
+    // дополненный последний блок собирается на стеке
+    size_t directSize = mode == Mode::CTR ? data.size() : data.size() - data.size() % BLOCK_SIZE;
+    size_t cipherSize = mode == Mode::CTR ? data.size() : directSize + BLOCK_SIZE;
+    
+    std::vector<uint8_t> result(cipherSize + MAC_SIZE);
+    
+    // Каждый фрагмент шифруется и сразу, пока он в кэше, добавляется в имитовставку
+    for (size_t offset = 0; offset < directSize; offset += MAC_CHUNK) {
+        size_t length = std::min(MAC_CHUNK, directSize - offset);
+        const uint8_t* previous = offset == 0 ? prepared.iv : &result[offset - BLOCK_SIZE];
+        
+        processChunk(&data[offset], &result[offset], offset, length, prepared, false, previous);
+        macUpdate(mac, &result[offset], length);
+    }
+    
+    if (mode != Mode::CTR) {
+        size_t tail = data.size() - directSize;
+        uint8_t lastBlock[BLOCK_SIZE];
+        if (tail != 0) {
+            std::memcpy(lastBlock, data.data() + directSize, tail);
         }
+        std::memset(lastBlock + tail, static_cast<int>(BLOCK_SIZE - tail), BLOCK_SIZE - tail);
+        
+        const uint8_t* previous = directSize == 0 ? prepared.iv : &result[directSize - BLOCK_SIZE];
+        processChunk(lastBlock, &result[directSize], directSize, BLOCK_SIZE, prepared, false, previous);
+        macUpdate(mac, &result[directSize], BLOCK_SIZE);
     }
     
+    macFinal(mac, &result[cipherSize]);
+    
     return result;
 }
 
-std::string MagmaCipher::encrypt(const std::string& plaintext, const std::string& key) {
-    std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
-    std::vector<uint8_t> encrypted = encryptBytes(data, key);
+std::vector<uint8_t> MagmaCipher::decryptWithMac(const std::vector<uint8_t>& data, const std::string& key,
+                                                 const std::string& macKey) {
+    PreparedKeyPtr prepared = prepareKey(key);
+    return decryptWithMac(data, *prepared, *prepareMacKey(macKey));
+}
+
+std::vector<uint8_t> MagmaCipher::decryptWithMac(const std::vector<uint8_t>& data, const PreparedKey& key,
+                                                 const PreparedKey& macKey) {
+    const Key& prepared = preparedKey(key);
+    
+    if (data.size() < MAC_SIZE) {
+        throw std::invalid_argument("Данные короче имитовставки");
+    }
+    
+    size_t cipherSize = data.size() - MAC_SIZE;
+    
+    if (mode != Mode::CTR && cipherSize % BLOCK_SIZE != 0) {
+        throw std::invalid_argument("Размер зашифрованных данных должен быть кратен 8 байтам");
+    }
+    
+    MacContext mac;
+    macInit(mac, preparedMacKey(macKey).subkeys);
     
-    // Преобразование в hex строку
-    std::ostringstream oss;
-    for (uint8_t byte : encrypted) {
-        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+    std::vector<uint8_t> result(cipherSize);
+    
+    // Имитовставка вычисляется по фрагменту шифртекста перед его расшифрованием
+    for (size_t offset = 0; offset < cipherSize; offset += MAC_CHUNK) {
+        size_t length = std::min(MAC_CHUNK, cipherSize - offset);
+        const uint8_t* previous = offset == 0 ? prepared.iv : &data[offset - BLOCK_SIZE];
+        
+        macUpdate(mac, &data[offset], length);
+        processChunk(&data[offset], &result[offset], offset, length, prepared, true, previous);
+    }
+    
+    uint8_t tag[MAC_SIZE];
+    macFinal(mac, tag);
+    
+    // Сравнение без раннего выхода
+    uint8_t diff = 0;
+    for (int i = 0; i < MAC_SIZE; i++) {
+        diff |= tag[i] ^ data[cipherSize + i];
+    }
+    
+    if (diff != 0) {
+        std::fill(result.begin(), result.end(), 0);
+        throw std::runtime_error("Имитовставка не совпадает: данные повреждены или ключ неверен");
+    }
+    
+    if (mode != Mode::CTR) {
+        removePadding(result);
     }
     
-    return oss.str();
+    return result;
 }
 
-std::string MagmaCipher::decrypt(const std::string& ciphertext, const std::string& key) {
-    // Преобразование hex строки в байты
-    std::vector<uint8_t> data;
-    for (size_t i = 0; i < ciphertext.length(); i += 2) {
-        std::string byteString = ciphertext.substr(i, 2);
-        uint8_t byte = static_cast<uint8_t>(std::stoul(byteString, nullptr, 16));
-        data.push_back(byte);
+// Потоковый контекст Магмы. В режимах ECB и CBC неполный блок накапливается между вызовами;
+// при дешифровании последний полный блок удерживается до finish, где снимается дополнение
+class MagmaCipher::Stream : public ICipherStream {
+public:
+    explicit Stream(const MagmaCipher& settings) : cipher(settings) {}
+    
+    void begin(const std::string& key, bool encrypt) override {
+        begin(*cipher.prepareKey(key), encrypt);
+    }
+    
+    void begin(const PreparedKey& key, bool encrypt) override {
+        const Key& prepared = cipher.preparedKey(key);
+        
+        subkeys = prepared.subkeys;
+        iv = prepared.ctrIv;
+        std::memcpy(chain, prepared.iv, BLOCK_SIZE);
+        
+        encrypting = encrypt;
+        offset = 0;
+        bufferSize = 0;
+        started = true;
+    }
+    
+    size_t update(const uint8_t* input, size_t length, uint8_t* output) override {
+        if (!started) {
+            throw std::logic_error("Поток не инициализирован: требуется begin");
+        }
+        
+        // Гаммирование: только смещение в потоке
+        if (cipher.mode == Mode::CTR) {
+            cipher.processCtr(input, output, length, subkeys, iv, offset);
+            offset += length;
+            return length;
+        }
+        
+        size_t written = 0;
+        
+        while (length > 0) {
+            // Накопленный полный блок выдается, только если за ним есть еще данные
+            if (bufferSize == BLOCK_SIZE) {
+                processFull(buffer, output + written, 1);
+                written += BLOCK_SIZE;
+                bufferSize = 0;
+            }
+            
+            // Основной объем - напрямую из входа, последние 1..8 байт остаются в буфере
+            if (bufferSize == 0 && length > BLOCK_SIZE) {
+                size_t blocks = (length - 1) / BLOCK_SIZE;
+                processFull(input, output + written, blocks);
+                written += blocks * BLOCK_SIZE;
+                input += blocks * BLOCK_SIZE;
+                length -= blocks * BLOCK_SIZE;
+            }
+            
+            size_t take = std::min(length, static_cast<size_t>(BLOCK_SIZE) - bufferSize);
+            std::memcpy(buffer + bufferSize, input, take);
+            bufferSize += take;
+            input += take;
+            length -= take;
+        }
+        
+        // При шифровании удерживать полный блок не нужно
+        if (encrypting && bufferSize == BLOCK_SIZE) {
+            processFull(buffer, output + written, 1);
+            written += BLOCK_SIZE;
+            bufferSize = 0;
+        }
+        
+        return written;
+    }
+    
+    size_t finish(uint8_t* output) override {
+        if (!started) {
+            throw std::logic_error("Поток не инициализирован: требуется begin");
+        }
+        
+        started = false;
+        
+        if (cipher.mode == Mode::CTR) {
+            return 0;
+        }
+        
+        // Дополнение PKCS7 последнего блока
+        if (encrypting) {
+            std::memset(buffer + bufferSize, static_cast<int>(BLOCK_SIZE - bufferSize), BLOCK_SIZE - bufferSize);
+            processFull(buffer, output, 1);
+            return BLOCK_SIZE;
+        }
+        
+        if (bufferSize == 0) {
+            return 0;
+        }
+        
+        if (bufferSize != BLOCK_SIZE) {
+            throw std::invalid_argument("Размер зашифрованных данных должен быть кратен 8 байтам");
+        }
+        
+        uint8_t block[BLOCK_SIZE];
+        processFull(buffer, block, 1);
+        
+        // Снятие дополнения по тем же правилам, что и removePadding
+        size_t length = BLOCK_SIZE;
+        uint8_t paddingSize = block[BLOCK_SIZE - 1];
+        if (paddingSize > 0 && paddingSize <= BLOCK_SIZE) {
+            length -= paddingSize;
+        }
+        
+        std::memcpy(output, block, length);
+        return length;
+    }
+    
+    size_t updateOutputSize(size_t length) const override {
+        return cipher.mode == Mode::CTR ? length : length + BLOCK_SIZE;
     }
     
+    size_t finishOutputSize() const override {
+        return cipher.mode == Mode::CTR ? 0 : BLOCK_SIZE;
+    }
+
+private:
+    // Полные блоки в режиме ECB или CBC (с переносом зацепления)
+    void processFull(const uint8_t* input, uint8_t* output, size_t blocks) {
+        if (cipher.mode == Mode::ECB) {
+            cipher.processEcb(input, output, blocks, subkeys, !encrypting);
+            return;
+        }
+        
+        if (encrypting) {
+            cipher.encryptCbc(input, output, blocks, subkeys, chain);
+            std::memcpy(chain, output + (blocks - 1) * BLOCK_SIZE, BLOCK_SIZE);
+        } else {
+            uint8_t next[BLOCK_SIZE];
+            std::memcpy(next, input + (blocks - 1) * BLOCK_SIZE, BLOCK_SIZE);
+            cipher.decryptCbc(input, output, blocks, subkeys, chain);
+            std::memcpy(chain, next, BLOCK_SIZE);
+        }
+    }
+    
+    MagmaCipher cipher;
+    std::array<uint32_t, 8> subkeys{};
+    uint32_t iv = 0;
+    uint8_t chain[BLOCK_SIZE] = {0};
+    uint8_t buffer[BLOCK_SIZE] = {0};
+    size_t bufferSize = 0;
+    uint64_t offset = 0;
+    bool encrypting = true;
+    bool started = false;
+};
+
+std::unique_ptr<ICipherStream> MagmaCipher::createStream() const {
+    return std::make_unique<Stream>(*this);
+}
+
+std::string MagmaCipher::encrypt(const std::string& plaintext, const std::string& key) {
+    return encrypt(plaintext, *prepareKey(key));
+}
+
+std::string MagmaCipher::encrypt(const std::string& plaintext, const PreparedKey& key) {
+    std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
+    std::vector<uint8_t> encrypted = encryptBytes(data, key);
+    return TextCodec::encode(encrypted, textEncoding);
+}
+
+std::string MagmaCipher::decrypt(const std::string& ciphertext, const std::string& key) {
+    return decrypt(ciphertext, *prepareKey(key));
+}
+
+std::string MagmaCipher::decrypt(const std::string& ciphertext, const PreparedKey& key) {
+    std::vector<uint8_t> data = TextCodec::decode(ciphertext, textEncoding);
     std::vector<uint8_t> decrypted = decryptBytes(data, key);
     return std::string(decrypted.begin(), decrypted.end());
 }
\ No newline at end of file
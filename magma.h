@@ -6,6 +6,14 @@
 
 // Реализация алгоритма шифрования ГОСТ 28147-89 (Магма)
 class MagmaCipher : public ICipher {
+public:
+    // Режимы работы блочного шифра по ГОСТ Р 34.13-2015
+    enum class Mode {
+        ECB,    // простая замена, дополнение PKCS7
+        CTR,    // гаммирование, без дополнения
+        CBC     // простая замена с зацеплением, дополнение PKCS7
+    };
+
 private:
     // Таблица замен S-box (по умолчанию используется id-tc26-gost-28147-param-Z)
     static const uint8_t SBOX[8][16];
@@ -19,8 +27,46 @@ private:
     // Размер ключа в байтах
     static const int KEY_SIZE = 32;
     
+    // Размер синхропосылки в байтах: половина блока для CTR, блок для CBC
+    static const int CTR_IV_SIZE = 4;
+    static const int CBC_IV_SIZE = 8;
+    
+    // Размер имитовставки в байтах (полный блок)
+    static const int MAC_SIZE = 8;
+    
+    // Текущий режим работы
+    Mode mode = Mode::ECB;
+    
+    // Представление шифртекста в текстовом режиме
+    TextEncoding textEncoding = TextEncoding::Hex;
+    
+    // Подготовленный ключ: подключи и синхропосылка режима, в котором ключ подготовлен
+    struct Key : PreparedKey {
+        Mode mode;
+        std::array<uint32_t, 8> subkeys;
+        uint8_t iv[CBC_IV_SIZE];
+        uint32_t ctrIv;
+    };
+    
+    // Проверка, что ключ подготовлен Магмой в текущем режиме
+    const Key& preparedKey(const PreparedKey& key) const;
+    
+    // Ключ имитовставки: подходит любой ключ Магмы, используются только подключи
+    static const Key& preparedMacKey(const PreparedKey& macKey);
+    
+    // Состояние выработки имитовставки (OMAC по ГОСТ Р 34.13-2015)
+    struct MacContext {
+        std::array<uint32_t, 8> subkeys;
+        uint8_t k1[BLOCK_SIZE];
+        uint8_t k2[BLOCK_SIZE];
+        uint8_t state[BLOCK_SIZE];
+        // Последний блок удерживается до конца: к нему применяется K1 или K2
+        uint8_t pending[BLOCK_SIZE];
+        size_t pendingSize;
+    };
+    
     // Преобразование ключа в подключи
-    std::array<uint32_t, 8> expandKey(const std::vector<uint8_t>& key);
+    static std::array<uint32_t, 8> expandKey(const std::vector<uint8_t>& key);
     
     // Функция t (подстановка через S-box)
     uint32_t tTransform(uint32_t value);
@@ -34,17 +80,121 @@ private:
     // Дешифрование одного блока
     void decryptBlock(const uint8_t* input, uint8_t* output, const std::array<uint32_t, 8>& subkeys);
     
+    // Таблицы раунда: для каждого байта слова пара S-box и сдвиг <<<11 уже применены
+    using RoundTables = std::array<std::array<uint32_t, 256>, 4>;
+    static const RoundTables& roundTables();
+    
+    // Функция g через таблицы (четыре выборки по байту и три XOR)
+    static uint32_t gTransformTable(uint32_t half, uint32_t key, const RoundTables& tables);
+    
+    // Табличное шифрование одного блока (результат совпадает с encryptBlock)
+    void encryptBlockTable(const uint8_t* input, uint8_t* output, const std::array<uint32_t, 8>& subkeys);
+    
+    // Табличное дешифрование одного блока (результат совпадает с decryptBlock)
+    void decryptBlockTable(const uint8_t* input, uint8_t* output, const std::array<uint32_t, 8>& subkeys);
+    
+    // Последовательность из 32 раундовых ключей для шифрования или дешифрования
+    static std::array<uint32_t, ROUNDS> roundKeySchedule(const std::array<uint32_t, 8>& subkeys, bool decrypt);
+    
+    // Обработка независимых блоков: векторное ядро, если доступно, хвост - табличным раундом
+    void processBlocks(const uint8_t* input, uint8_t* output, size_t blocks,
+                       const std::array<uint32_t, 8>& subkeys, bool decrypt);
+    
+    // Режим простой замены: блоки независимы, фрагменты обрабатываются параллельно (допускается output == input)
+    void processEcb(const uint8_t* input, uint8_t* output, size_t blocks,
+                    const std::array<uint32_t, 8>& subkeys, bool decrypt);
+    
+    // Блок счетчика CTR: (IV || 0^32) + index по модулю 2^64, старший байт первым
+    static void ctrBlock(uint32_t iv, uint64_t index, uint8_t* output);
+    
+    // Гаммирование: offset - смещение в байтах от начала потока (произвольный доступ)
+    void processCtr(const uint8_t* input, uint8_t* output, size_t length,
+                    const std::array<uint32_t, 8>& subkeys, uint32_t iv, uint64_t offset);
+    
+    // Шифрование с зацеплением (последовательное)
+    void encryptCbc(const uint8_t* input, uint8_t* output, size_t blocks,
+                    const std::array<uint32_t, 8>& subkeys, const uint8_t* iv);
+    
+    // Дешифрование с зацеплением (блоки независимы, выполняется параллельно; допускается output == input)
+    void decryptCbc(const uint8_t* input, uint8_t* output, size_t blocks,
+                    const std::array<uint32_t, 8>& subkeys, const uint8_t* iv);
+    
+    // Обработка фрагмента данных в текущем режиме; offset - смещение фрагмента в потоке
+    void processChunk(const uint8_t* input, uint8_t* output, size_t offset, size_t length,
+                      const Key& key, bool decrypt, const uint8_t* previousBlock);
+    
+    // Инициализация имитовставки: вычисление K1, K2 из E(0)
+    void macInit(MacContext& ctx, const std::array<uint32_t, 8>& macSubkeys);
+    
+    // Добавление данных в имитовставку
+    void macUpdate(MacContext& ctx, const uint8_t* data, size_t length);
+    
+    // Завершение имитовставки
+    void macFinal(MacContext& ctx, uint8_t* tag);
+    
+    // Проверка ключа имитовставки (64 hex символа)
+    static bool validateMacKey(const std::string& macKey);
+    
+    // Длина корректного дополнения PKCS7 в конце данных (0, если дополнение некорректно)
+    static size_t paddingSize(const uint8_t* data, size_t length);
+    
+    // Удаление дополнения PKCS7
+    static void removePadding(std::vector<uint8_t>& data);
+    
+    // Длина синхропосылки для текущего режима
+    int ivSize() const;
+    
     // Преобразование строки ключа в байты
-    std::vector<uint8_t> keyToBytes(const std::string& key);
+    std::vector<uint8_t> keyToBytes(const std::string& key) const;
+    
+    // Потоковый контекст (определен в magma.cpp)
+    class Stream;
 
 public:
     std::string encrypt(const std::string& plaintext, const std::string& key) override;
     std::string decrypt(const std::string& ciphertext, const std::string& key) override;
     std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const std::string& key) override;
     std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const std::string& key) override;
+    PreparedKeyPtr prepareKey(const std::string& key) const override;
+    std::string encrypt(const std::string& plaintext, const PreparedKey& key) override;
+    std::string decrypt(const std::string& ciphertext, const PreparedKey& key) override;
+    std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) override;
+    std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) override;
+    size_t encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) override;
+    size_t decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) override;
+    size_t encryptedSize(size_t length) const override;
+    size_t decryptedSize(size_t length) const override;
     std::string getName() const override { return "Магма (ГОСТ 28147-89)"; }
-    std::string getKeyFormat() const override { return "64 шестнадцатеричных символа (32 байта)"; }
+    std::string getKeyFormat() const override;
     bool validateKey(const std::string& key) const override;
+    std::unique_ptr<ICipherStream> createStream() const override;
+    bool supportsStreaming() const override { return true; }
+    void setTextEncoding(TextEncoding encoding) override { textEncoding = encoding; }
+    TextEncoding getTextEncoding() const override { return textEncoding; }
+    
+    // Выбор режима работы
+    void setMode(Mode newMode) { mode = newMode; }
+    Mode getMode() const { return mode; }
+    
+    // Гаммирование фрагмента, начинающегося со смещения offset (только режим CTR)
+    std::vector<uint8_t> cryptAt(const std::vector<uint8_t>& data, const std::string& key, uint64_t offset);
+    std::vector<uint8_t> cryptAt(const std::vector<uint8_t>& data, const PreparedKey& key, uint64_t offset);
+    
+    // Подготовка ключа имитовставки (64 hex символа) независимо от режима
+    PreparedKeyPtr prepareMacKey(const std::string& macKey) const;
+    
+    // Шифрование с имитовставкой за один проход: результат - шифртекст и 8 байт имитовставки.
+    // Имитовставка вычисляется по шифртексту на отдельном ключе macKey (64 hex символа)
+    std::vector<uint8_t> encryptWithMac(const std::vector<uint8_t>& data, const std::string& key, const std::string& macKey);
+    std::vector<uint8_t> encryptWithMac(const std::vector<uint8_t>& data, const PreparedKey& key, const PreparedKey& macKey);
+    
+    // Дешифрование с проверкой имитовставки в том же проходе; при несовпадении - исключение
+    std::vector<uint8_t> decryptWithMac(const std::vector<uint8_t>& data, const std::string& key, const std::string& macKey);
+    std::vector<uint8_t> decryptWithMac(const std::vector<uint8_t>& data, const PreparedKey& key, const PreparedKey& macKey);
+    
+    // Самопроверка ядра MagmaSimd::Kernel (для KernelRegistry): шифрование и дешифрование
+    // блоков должны совпасть с encryptBlock; Scalar проверяет табличный раунд
+    static bool verifyKernel(int kernel);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "../include/magma_simd.h"
+#include "../include/cpu_features.h"
+
+#ifdef RGR_X86_SIMD
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+#ifdef RGR_X86_SIMD
+
+// Таблицы для pshufb: для байта j слова младший полубайт идет через SBOX[2j],
+// старший - через SBOX[2j+1] (значение уже сдвинуто на 4 бита)
+struct ShuffleTables {
+    alignas(16) uint8_t low[4][16];
+    alignas(16) uint8_t high[4][16];
+    
+    explicit ShuffleTables(const uint8_t sbox[8][16]) {
+        for (int j = 0; j < 4; j++) {
+            for (int n = 0; n < 16; n++) {
+                low[j][n] = sbox[2 * j][n];
+                high[j][n] = static_cast<uint8_t>(sbox[2 * j + 1][n] << 4);
+            }
+        }
+    }
+};
+
+__attribute__((target("ssse3")))
+inline __m128i gTransformSsse3(__m128i half, __m128i key, const __m128i low[4], const __m128i high[4],
+                               const __m128i byteMask[4], __m128i nibbleMask) {
+    __m128i sum = _mm_add_epi32(half, key);
+    __m128i lo = _mm_and_si128(sum, nibbleMask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(sum, 4), nibbleMask);
+    
+    __m128i substituted = _mm_setzero_si128();
+    for (int j = 0; j < 4; j++) {
+        __m128i t = _mm_or_si128(_mm_shuffle_epi8(low[j], lo), _mm_shuffle_epi8(high[j], hi));
+        substituted = _mm_or_si128(substituted, _mm_and_si128(t, byteMask[j]));
+    }
+    
+    return _mm_or_si128(_mm_slli_epi32(substituted, 11), _mm_srli_epi32(substituted, 21));
+}
+
+__attribute__((target("avx2")))
+inline __m256i gTransformAvx2(__m256i half, __m256i key, const __m256i low[4], const __m256i high[4],
+                              const __m256i byteMask[4], __m256i nibbleMask) {
+    __m256i sum = _mm256_add_epi32(half, key);
+    __m256i lo = _mm256_and_si256(sum, nibbleMask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(sum, 4), nibbleMask);
+    
+    __m256i substituted = _mm256_setzero_si256();
+    for (int j = 0; j < 4; j++) {
+        __m256i t = _mm256_or_si256(_mm256_shuffle_epi8(low[j], lo), _mm256_shuffle_epi8(high[j], hi));
+        substituted = _mm256_or_si256(substituted, _mm256_and_si256(t, byteMask[j]));
+    }
+    
+    return _mm256_or_si256(_mm256_slli_epi32(substituted, 11), _mm256_srli_epi32(substituted, 21));
+}
+
+#endif
+
+}
+
+size_t MagmaSimd::processBlocks(int kernel, const uint8_t* input, uint8_t* output, size_t blocks,
+                                const std::array<uint32_t, 32>& roundKeys, const uint8_t sbox[8][16]) {
+    switch (kernel) {
+        case Avx2:
+            return processBlocksAvx2(input, output, blocks, roundKeys, sbox);
+        case Ssse3:
+            return processBlocksSsse3(input, output, blocks, roundKeys, sbox);
+        default:
+            return 0;
+    }
+}
+
+#ifdef RGR_X86_SIMD
+
+__attribute__((target("ssse3")))
+size_t MagmaSimd::processBlocksSsse3(const uint8_t* input, uint8_t* output, size_t blocks,
+                                     const std::array<uint32_t, 32>& roundKeys, const uint8_t sbox[8][16]) {
+    ShuffleTables tables(sbox);
+    
+    __m128i low[4];
+    __m128i high[4];
+    __m128i byteMask[4];
+    for (int j = 0; j < 4; j++) {
+        low[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.low[j]));
+        high[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.high[j]));
+        byteMask[j] = _mm_set1_epi32(static_cast<int>(0xFFu << (j * 8)));
+    }
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    
+    size_t processed = blocks - blocks % SSSE3_LANES;
+    
+    for (size_t i = 0; i < processed; i += SSSE3_LANES) {
+        // Разделение 4 блоков на левые и правые половины
+        __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 8)));
+        __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 8 + 16)));
+        __m128i left = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i right = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        
+        for (int r = 0; r < 32; r++) {
+            __m128i key = _mm_set1_epi32(static_cast<int>(roundKeys[r]));
+            __m128i temp = _mm_xor_si128(left, gTransformSsse3(right, key, low, high, byteMask, nibbleMask));
+            left = right;
+            right = temp;
+        }
+        
+        // Запись результата: в каждом блоке сначала правая половина, затем левая
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 8), _mm_unpacklo_epi32(right, left));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 8 + 16), _mm_unpackhi_epi32(right, left));
+    }
+    
+    return processed;
+}
+
+__attribute__((target("avx2")))
+size_t MagmaSimd::processBlocksAvx2(const uint8_t* input, uint8_t* output, size_t blocks,
+                                    const std::array<uint32_t, 32>& roundKeys, const uint8_t sbox[8][16]) {
+    ShuffleTables tables(sbox);
+    
+    __m256i low[4];
+    __m256i high[4];
+    __m256i byteMask[4];
+    for (int j = 0; j < 4; j++) {
+        low[j] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.low[j])));
+        high[j] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.high[j])));
+        byteMask[j] = _mm256_set1_epi32(static_cast<int>(0xFFu << (j * 8)));
+    }
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+    
+    size_t processed = blocks - blocks % AVX2_LANES;
+    
+    for (size_t i = 0; i < processed; i += AVX2_LANES) {
+        // Разделение 8 блоков на левые и правые половины (порядок полос внутри 128-битных половин)
+        __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i * 8)));
+        __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i * 8 + 32)));
+        __m256i left = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m256i right = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        
+        for (int r = 0; r < 32; r++) {
+            __m256i key = _mm256_set1_epi32(static_cast<int>(roundKeys[r]));
+            __m256i temp = _mm256_xor_si256(left, gTransformAvx2(right, key, low, high, byteMask, nibbleMask));
+            left = right;
+            right = temp;
+        }
+        
+        // Обратная перестановка восстанавливает исходный порядок блоков
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 8), _mm256_unpacklo_epi32(right, left));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 8 + 32), _mm256_unpackhi_epi32(right, left));
+    }
+    
+    return processed;
+}
+
+#else
+
+size_t MagmaSimd::processBlocksSsse3(const uint8_t*, uint8_t*, size_t,
+                                     const std::array<uint32_t, 32>&, const uint8_t[8][16]) {
+    return 0;
+}
+
+size_t MagmaSimd::processBlocksAvx2(const uint8_t*, uint8_t*, size_t,
+                                    const std::array<uint32_t, 32>&, const uint8_t[8][16]) {
+    return 0;
+}
+
+#endif
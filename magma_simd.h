@@ -0,0 +1,37 @@
+#ifndef MAGMA_SIMD_H
+#define MAGMA_SIMD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Векторные ядра Магмы: несколько независимых 64-битных блоков обрабатываются
+// в полосах SIMD, подстановка t выполняется через pshufb (строка S-box = 16 байт)
+class MagmaSimd {
+public:
+    // Ядра по возрастанию ширины; значения - индексы в KernelRegistry
+    enum Kernel {
+        Scalar,     // векторного ядра нет, блоки обрабатывает табличный раунд
+        Ssse3,
+        Avx2
+    };
+    
+    // Число блоков за одну итерацию ядра
+    static const int SSSE3_LANES = 4;
+    static const int AVX2_LANES = 8;
+    
+    // Обработка блоков заданным ядром (процессор должен его поддерживать).
+    // roundKeys - 32 раундовых ключа в порядке применения (шифрование или дешифрование).
+    // Возвращает число обработанных блоков (кратно ширине ядра, 0 для Scalar), хвост остается вызывающему
+    static size_t processBlocks(int kernel, const uint8_t* input, uint8_t* output, size_t blocks,
+                                const std::array<uint32_t, 32>& roundKeys, const uint8_t sbox[8][16]);
+
+private:
+    static size_t processBlocksSsse3(const uint8_t* input, uint8_t* output, size_t blocks,
+                                     const std::array<uint32_t, 32>& roundKeys, const uint8_t sbox[8][16]);
+    
+    static size_t processBlocksAvx2(const uint8_t* input, uint8_t* output, size_t blocks,
+                                    const std::array<uint32_t, 32>& roundKeys, const uint8_t sbox[8][16]);
+};
+
+#endif
@@ -2,13 +2,26 @@
 #include <memory>
 #include <vector>
 #include <limits>
+#include <stdexcept>
 #include <clocale>
+#include <cctype>
+#include <cstdlib>
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#endif
 #include "../include/cipher_interface.h"
 #include "../include/magma.h"
 #include "../include/trithemius.h"
 #include "../include/chacha20.h"
 #include "../include/key_generator.h"
 #include "../include/file_handler.h"
+#include "../include/pipeline.h"
+#include "../include/thread_pool.h"
+#include "../include/batch_processor.h"
+#include "../include/kernel_registry.h"
+#include "../include/stage_stats.h"
+#include "../include/trace_log.h"
 
 // Очистка буфера ввода
 void clearInput() {
@@ -24,11 +37,95 @@ void displayMainMenu() {
     std::cout << "1. Шифрование/дешифрование текста\n";
     std::cout << "2. Шифрование/дешифрование файла\n";
     std::cout << "3. Генератор ключей\n";
+    std::cout << "4. Пакетная обработка каталога\n";
+    std::cout << "5. Статистика стадий обработки\n";
     std::cout << "0. Выход\n";
     std::cout << "========================================\n";
     std::cout << "Выберите действие: ";
 }
 
+// Выбор режима работы Магмы
+MagmaCipher::Mode selectMagmaMode() {
+    std::cout << "\n--- Режим работы Магмы ---\n";
+    std::cout << "1. Простая замена (ECB)\n";
+    std::cout << "2. Гаммирование (CTR)\n";
+    std::cout << "3. Простая замена с зацеплением (CBC)\n";
+    std::cout << "Выберите режим: ";
+    
+    int choice;
+    std::cin >> choice;
+    clearInput();
+    
+    switch (choice) {
+        case 2:
+            return MagmaCipher::Mode::CTR;
+        case 3:
+            return MagmaCipher::Mode::CBC;
+        default:
+            return MagmaCipher::Mode::ECB;
+    }
+}
+
+// Выбор режима работы ChaCha20
+ChaCha20Cipher::Mode selectChaChaMode() {
+    std::cout << "\n--- Режим работы ChaCha20 ---\n";
+    std::cout << "1. Поточное шифрование\n";
+    std::cout << "2. Аутентифицированное шифрование ChaCha20-Poly1305\n";
+    std::cout << "Выберите режим: ";
+    
+    int choice;
+    std::cin >> choice;
+    clearInput();
+    
+    return choice == 2 ? ChaCha20Cipher::Mode::Poly1305 : ChaCha20Cipher::Mode::Stream;
+}
+
+// Выбор варианта счетчика ChaCha20
+ChaCha20Cipher::Variant selectChaChaVariant() {
+    std::cout << "\n--- Вариант ChaCha20 ---\n";
+    std::cout << "1. RFC 8439 (32-битный счетчик, до 256 ГиБ)\n";
+    std::cout << "2. 64-битный счетчик\n";
+    std::cout << "3. XChaCha20 (nonce 24 байта)\n";
+    std::cout << "Выберите вариант: ";
+    
+    int choice;
+    std::cin >> choice;
+    clearInput();
+    
+    switch (choice) {
+        case 2:
+            return ChaCha20Cipher::Variant::Counter64;
+        case 3:
+            return ChaCha20Cipher::Variant::XChaCha20;
+        default:
+            return ChaCha20Cipher::Variant::IETF;
+    }
+}
+
+// Выбор текстового представления шифртекста; по умолчанию сохраняется текущее
+TextEncoding selectTextEncoding(TextEncoding current) {
+    std::cout << "\n--- Представление шифртекста ---\n";
+    std::cout << "1. Без кодирования (байты)\n";
+    std::cout << "2. Hex\n";
+    std::cout << "3. Base64\n";
+    std::cout << "Выберите представление (текущее: " << TextCodec::encodingName(current) << "): ";
+    
+    int choice;
+    std::cin >> choice;
+    clearInput();
+    
+    switch (choice) {
+        case 1:
+            return TextEncoding::Raw;
+        case 2:
+            return TextEncoding::Hex;
+        case 3:
+            return TextEncoding::Base64;
+        default:
+            return current;
+    }
+}
+
 // Отображение меню выбора алгоритма
 int selectCipher(std::unique_ptr<ICipher>& cipher) {
     std::cout << "\n--- Выбор алгоритма шифрования ---\n";
@@ -43,15 +140,30 @@ int selectCipher(std::unique_ptr<ICipher>& cipher) {
     clearInput();
     
     switch (choice) {
-        case 1:
-            cipher = std::make_unique<MagmaCipher>();
+        case 1: {
+            auto magma = std::make_unique<MagmaCipher>();
+            magma->setMode(selectMagmaMode());
+            cipher = std::move(magma);
             break;
+        }
         case 2:
             cipher = std::make_unique<TrithemiusCipher>();
             break;
-        case 3:
-            cipher = std::make_unique<ChaCha20Cipher>();
+        case 3: {
+            auto chacha = std::make_unique<ChaCha20Cipher>();
+            chacha->setVariant(selectChaChaVariant());
+            chacha->setMode(selectChaChaMode());
+            
+            if (chacha->getMode() == ChaCha20Cipher::Mode::Poly1305) {
+                std::cout << "Ассоциированные данные (можно оставить пустыми): ";
+                std::string aad;
+                std::getline(std::cin, aad);
+                chacha->setAssociatedData(std::vector<uint8_t>(aad.begin(), aad.end()));
+            }
+            
+            cipher = std::move(chacha);
             break;
+        }
         case 0:
             return 0;
         default:
@@ -114,6 +226,8 @@ void processText() {
         return;
     }
     
+    cipher->setTextEncoding(selectTextEncoding(cipher->getTextEncoding()));
+    
     // Ввод ключа
     std::string key = inputKey(cipher);
     if (key.empty()) {
@@ -171,6 +285,74 @@ void processText() {
     }
 }
 
+// Дешифрование фрагмента файла без обработки предшествующих данных
+// (потоковые режимы: ChaCha20 и Магма в режиме гаммирования)
+void processFileSlice(const std::unique_ptr<ICipher>& cipher, const std::string& key) {
+    ChaCha20Cipher* chacha = dynamic_cast<ChaCha20Cipher*>(cipher.get());
+    MagmaCipher* magma = dynamic_cast<MagmaCipher*>(cipher.get());
+    
+    bool seekable = (chacha && chacha->getMode() == ChaCha20Cipher::Mode::Stream) ||
+                    (magma && magma->getMode() == MagmaCipher::Mode::CTR);
+    
+    if (!seekable) {
+        std::cout << "Фрагмент можно расшифровать только для ChaCha20 без Poly1305 и Магмы в режиме гаммирования!\n";
+        return;
+    }
+    
+    std::cout << "\nВведите путь к зашифрованному файлу: ";
+    std::string inputPath;
+    std::getline(std::cin, inputPath);
+    
+    if (!FileHandler::fileExists(inputPath)) {
+        std::cout << "Ошибка: файл не существует!\n";
+        return;
+    }
+    
+    uint64_t offset;
+    size_t length;
+    std::cout << "Смещение фрагмента (байт): ";
+    std::cin >> offset;
+    std::cout << "Длина фрагмента (байт): ";
+    std::cin >> length;
+    
+    if (!std::cin) {
+        clearInput();
+        std::cout << "Неверное значение!\n";
+        return;
+    }
+    clearInput();
+    
+    std::cout << "Введите путь к результирующему файлу: ";
+    std::string outputPath;
+    std::getline(std::cin, outputPath);
+    
+    try {
+        std::vector<uint8_t> data = FileHandler::readFileRange(inputPath, offset, length);
+        std::cout << "Прочитано байт: " << data.size() << "\n";
+        
+        PreparedKeyPtr prepared;
+        {
+            StageStats::Timer timer(StageStats::KeySetup);
+            prepared = cipher->prepareKey(key);
+        }
+        
+        std::vector<uint8_t> result;
+        {
+            StageStats::Timer timer(StageStats::Cipher, data.size());
+            result = chacha ? chacha->cryptAt(data, *prepared, offset) : magma->cryptAt(data, *prepared, offset);
+        }
+        
+        if (FileHandler::writeFile(outputPath, result)) {
+            std::cout << "\nУспешно завершено!\n";
+            std::cout << "Результат сохранен в: " << outputPath << "\n";
+        } else {
+            std::cout << "\nОшибка при записи файла!\n";
+        }
+    } catch (const std::exception& e) {
+        std::cout << "\nОшибка при обработке файла: " << e.what() << "\n";
+    }
+}
+
 // Обработка шифрования/дешифрования файла
 void processFile() {
     std::unique_ptr<ICipher> cipher;
@@ -184,13 +366,14 @@ void processFile() {
     std::cout << "\n--- Выбор операции ---\n";
     std::cout << "1. Шифрование файла\n";
     std::cout << "2. Дешифрование файла\n";
+    std::cout << "3. Дешифрование фрагмента файла\n";
     std::cout << "Выберите операцию: ";
     
     int operation;
     std::cin >> operation;
     clearInput();
     
-    if (operation != 1 && operation != 2) {
+    if (operation != 1 && operation != 2 && operation != 3) {
         std::cout << "Неверный выбор операции!\n";
         return;
     }
@@ -202,6 +385,31 @@ void processFile() {
         return;
     }
     
+    if (operation == 3) {
+        processFileSlice(cipher, key);
+        return;
+    }
+    
+    // Имитовставка для Магмы (вырабатывается в том же проходе, что и шифрование)
+    MagmaCipher* magma = dynamic_cast<MagmaCipher*>(cipher.get());
+    std::string macKey;
+    
+    if (magma) {
+        std::cout << "Использовать имитовставку? (да/нет): ";
+        std::string macChoice;
+        std::getline(std::cin, macChoice);
+        
+        if (macChoice == "да" || macChoice == "yes" || macChoice == "y") {
+            std::cout << "Введите ключ имитовставки (64 hex символа): ";
+            std::getline(std::cin, macKey);
+            
+            if (macKey.empty()) {
+                std::cout << "Операция отменена.\n";
+                return;
+            }
+        }
+    }
+    
     // Ввод пути к входному файлу
     std::cout << "\nВведите путь к исходному файлу: ";
     std::string inputPath;
@@ -212,41 +420,137 @@ void processFile() {
         return;
     }
     
+    // Потоковый контекст для обработки через отображение файлов в память
+    // (имитовставка и AEAD обрабатывают данные целиком)
+    std::unique_ptr<ICipherStream> stream;
+    
+    if (macKey.empty() && cipher->supportsStreaming()) {
+        stream = cipher->createStream();
+    }
+    
+    // Поточные шифры могут перезаписать страницы исходного файла
+    bool inPlace = false;
+    
+    if (stream && FileHandler::canProcessInPlace(*stream)) {
+        std::cout << "Обработать файл на месте (перезаписать исходный)? (да/нет): ";
+        std::string inPlaceChoice;
+        std::getline(std::cin, inPlaceChoice);
+        
+        inPlace = inPlaceChoice == "да" || inPlaceChoice == "yes" || inPlaceChoice == "y";
+    }
+    
+    // Способ обработки в отдельный файл: отображение в память, конвейер
+    // с одновременными чтением, шифрованием и записью или асинхронный ввод-вывод
+    bool pipelined = false;
+    bool asyncIo = false;
+    
+    if (stream && !inPlace) {
+        std::cout << "Способ обработки:\n";
+        std::cout << "1. Отображение файлов в память\n";
+        std::cout << "2. Конвейер (чтение, шифрование и запись одновременно)\n";
+        std::cout << "3. Асинхронный ввод-вывод (io_uring)\n";
+        std::cout << "Выберите способ: ";
+        
+        int method;
+        std::cin >> method;
+        clearInput();
+        
+        pipelined = method == 2;
+        asyncIo = method == 3;
+        
+        if (asyncIo && !FileHandler::asyncIoAvailable()) {
+            std::cout << "io_uring недоступен, используется обычный ввод-вывод фрагментами\n";
+        }
+    }
+    
     // Ввод пути к выходному файлу
-    std::cout << "Введите путь к результирующему файлу: ";
-    std::string outputPath;
-    std::getline(std::cin, outputPath);
+    std::string outputPath = inputPath;
     
-    // Проверка существования выходного файла
-    if (FileHandler::fileExists(outputPath)) {
-        std::cout << "Файл уже существует. Перезаписать? (да/нет): ";
-        std::string overwrite;
-        std::getline(std::cin, overwrite);
+    if (!inPlace) {
+        std::cout << "Введите путь к результирующему файлу: ";
+        std::getline(std::cin, outputPath);
         
-        if (overwrite != "да" && overwrite != "yes" && overwrite != "y") {
-            std::cout << "Операция отменена.\n";
-            return;
+        // Проверка существования выходного файла
+        if (FileHandler::fileExists(outputPath)) {
+            std::cout << "Файл уже существует. Перезаписать? (да/нет): ";
+            std::string overwrite;
+            std::getline(std::cin, overwrite);
+            
+            if (overwrite != "да" && overwrite != "yes" && overwrite != "y") {
+                std::cout << "Операция отменена.\n";
+                return;
+            }
+        } else {
+            // Попытка создать директории если нужно
+            FileHandler::createDirectories(outputPath);
         }
-    } else {
-        // Попытка создать директории если нужно
-        FileHandler::createDirectories(outputPath);
     }
     
     // Выполнение операции
     try {
+        // Отображение в память: без промежуточных буферов размером с файл.
+        // При совпадении путей (кроме обработки на месте) используется чтение целиком
+        if (stream && (inPlace || !FileHandler::sameFile(inputPath, outputPath))) {
+            {
+                StageStats::Timer timer(StageStats::KeySetup);
+                stream->begin(key, operation == 1);
+            }
+            std::cout << "\nВыполняется " << (operation == 1 ? "шифрование" : "дешифрование") << "...\n";
+            
+            uint64_t resultSize;
+            
+            if (pipelined) {
+                FilePipeline pipeline;
+                FilePipeline::Stats stats = pipeline.run(inputPath, outputPath, *stream);
+                resultSize = stats.bytesWritten;
+                
+                std::cout << "Время: " << stats.seconds << " с, фрагментов: " << stats.chunks << "\n";
+                std::cout << "Загрузка стадий: чтение " << static_cast<int>(stats.readerBusy * 100)
+                          << "%, шифрование " << static_cast<int>(stats.cipherBusy * 100)
+                          << "%, запись " << static_cast<int>(stats.writerBusy * 100) << "%\n";
+                std::cout << "Заполненность очередей: перед шифрованием " << static_cast<int>(stats.cipherQueueFill * 100)
+                          << "%, перед записью " << static_cast<int>(stats.writerQueueFill * 100) << "%\n";
+            } else if (asyncIo) {
+                resultSize = FileHandler::processAsync(inputPath, outputPath, *stream);
+            } else if (inPlace) {
+                resultSize = FileHandler::processInPlace(inputPath, *stream);
+            } else {
+                resultSize = FileHandler::processMapped(inputPath, outputPath, *stream);
+            }
+            
+            std::cout << "\nУспешно завершено!\n";
+            std::cout << "Результат сохранен в: " << outputPath << "\n";
+            std::cout << "Размер результата: " << resultSize << " байт\n";
+            return;
+        }
+        
         std::cout << "\nЧтение файла...\n";
         std::vector<uint8_t> data = FileHandler::readFile(inputPath);
         
         std::cout << "Размер файла: " << data.size() << " байт\n";
         
+        // Ключи разбираются отдельно от шифрования, чтобы стадии учитывались раздельно
+        PreparedKeyPtr prepared;
+        PreparedKeyPtr preparedMac;
+        {
+            StageStats::Timer timer(StageStats::KeySetup);
+            prepared = cipher->prepareKey(key);
+            
+            if (!macKey.empty()) {
+                preparedMac = magma->prepareMacKey(macKey);
+            }
+        }
+        
         std::vector<uint8_t> result;
         
         if (operation == 1) {
             std::cout << "Выполняется шифрование...\n";
-            result = cipher->encryptBytes(data, key);
+            StageStats::Timer timer(StageStats::Cipher, data.size());
+            result = macKey.empty() ? cipher->encryptBytes(data, *prepared) : magma->encryptWithMac(data, *prepared, *preparedMac);
         } else {
             std::cout << "Выполняется дешифрование...\n";
-            result = cipher->decryptBytes(data, key);
+            StageStats::Timer timer(StageStats::Cipher, data.size());
+            result = macKey.empty() ? cipher->decryptBytes(data, *prepared) : magma->decryptWithMac(data, *prepared, *preparedMac);
         }
         
         std::cout << "Запись результата в файл...\n";
@@ -264,6 +568,69 @@ void processFile() {
     }
 }
 
+// Пакетная обработка всех файлов дерева каталогов
+void processDirectory() {
+    std::unique_ptr<ICipher> cipher;
+    
+    // Выбор алгоритма
+    if (selectCipher(cipher) <= 0) {
+        return;
+    }
+    
+    // Выбор операции
+    std::cout << "\n--- Выбор операции ---\n";
+    std::cout << "1. Шифрование каталога\n";
+    std::cout << "2. Дешифрование каталога\n";
+    std::cout << "Выберите операцию: ";
+    
+    int operation;
+    std::cin >> operation;
+    clearInput();
+    
+    if (operation != 1 && operation != 2) {
+        std::cout << "Неверный выбор операции!\n";
+        return;
+    }
+    
+    // Ввод ключа
+    std::string key = inputKey(cipher);
+    if (key.empty()) {
+        std::cout << "Операция отменена.\n";
+        return;
+    }
+    
+    std::cout << "\nВведите путь к исходному каталогу: ";
+    std::string inputDir;
+    std::getline(std::cin, inputDir);
+    
+    std::cout << "Введите путь к результирующему каталогу: ";
+    std::string outputDir;
+    std::getline(std::cin, outputDir);
+    
+    try {
+        BatchProcessor batch(*cipher, key, operation == 1);
+        
+        std::cout << "\nВыполняется " << (operation == 1 ? "шифрование" : "дешифрование") << "...\n";
+        BatchProcessor::Stats stats = batch.run(inputDir, outputDir);
+        
+        std::cout << "\nОбработано файлов: " << stats.files - stats.failed << " из " << stats.files << "\n";
+        std::cout << "Прочитано байт: " << stats.bytesRead << ", записано байт: " << stats.bytesWritten << "\n";
+        std::cout << "Время: " << stats.seconds << " с, скорость: " << stats.throughput() << " МиБ/с\n";
+        
+        // Первые ошибки (остальные только подсчитываются)
+        const size_t shownErrors = 10;
+        for (size_t i = 0; i < stats.errors.size() && i < shownErrors; i++) {
+            std::cout << "Ошибка: " << stats.errors[i] << "\n";
+        }
+        
+        if (stats.errors.size() > shownErrors) {
+            std::cout << "... и еще " << stats.errors.size() - shownErrors << " ошибок\n";
+        }
+    } catch (const std::exception& e) {
+        std::cout << "\nОшибка при обработке каталога: " << e.what() << "\n";
+    }
+}
+
 // Генератор ключей
 void keyGenerator() {
     std::cout << "\n========================================\n";
@@ -282,12 +649,23 @@ void keyGenerator() {
     std::string key;
     
     switch (choice) {
-        case 1:
-            key = KeyGenerator::generateMagmaKey();
+        case 1: {
+            MagmaCipher magma;
+            magma.setMode(selectMagmaMode());
+            
+            if (magma.getMode() == MagmaCipher::Mode::CTR) {
+                key = KeyGenerator::generateMagmaCtrKey();
+            } else if (magma.getMode() == MagmaCipher::Mode::CBC) {
+                key = KeyGenerator::generateMagmaCbcKey();
+            } else {
+                key = KeyGenerator::generateMagmaKey();
+            }
+            
             std::cout << "\n--- Ключ для Магма ---\n";
             std::cout << key << "\n";
-            std::cout << "\nФормат: 64 шестнадцатеричных символа (32 байта)\n";
+            std::cout << "\nФормат: " << magma.getKeyFormat() << "\n";
             break;
+        }
             
         case 2:
             key = KeyGenerator::generateTrithemiusKey();
@@ -296,12 +674,23 @@ void keyGenerator() {
             std::cout << "\nФормат: a,b,c где a,b,c - коэффициенты функции k(p) = ap + b + c\n";
             break;
             
-        case 3:
-            key = KeyGenerator::generateChaCha20Key();
+        case 3: {
+            ChaCha20Cipher chacha;
+            chacha.setVariant(selectChaChaVariant());
+            
+            if (chacha.getVariant() == ChaCha20Cipher::Variant::Counter64) {
+                key = KeyGenerator::generateChaCha20Counter64Key();
+            } else if (chacha.getVariant() == ChaCha20Cipher::Variant::XChaCha20) {
+                key = KeyGenerator::generateXChaCha20Key();
+            } else {
+                key = KeyGenerator::generateChaCha20Key();
+            }
+            
             std::cout << "\n--- Ключ для ChaCha20 ---\n";
             std::cout << key << "\n";
-            std::cout << "\nФормат: 88 hex символов (64 для ключа + 24 для nonce)\n";
+            std::cout << "\nФормат: " << chacha.getKeyFormat() << "\n";
             break;
+        }
             
         case 0:
             return;
@@ -331,11 +720,268 @@ void keyGenerator() {
     }
 }
 
+// Параметры командной строки
+struct CommandLine {
+    bool filter = false;            // режим фильтра: enc/dec из stdin в stdout без диалога
+    bool encrypt = true;
+    std::string algorithm;          // magma, trithemius, chacha20
+    std::string mode;               // Магма: ecb, ctr, cbc
+    std::string variant;            // ChaCha20: ietf, counter64, xchacha20
+    std::string key;
+    std::string keyFile;
+    size_t chunkSize = 1 << 20;     // размер фрагмента в режиме фильтра
+    std::string statsPath;          // файл статистики стадий при завершении ("-" - stderr)
+    std::string tracePath;          // файл трассировки (Chrome trace event) при завершении
+};
+
+// Файл статистики стадий, записываемой при завершении программы
+std::string statsOutput;
+
+// Запись статистики стадий при завершении (регистрируется через std::atexit)
+void dumpStatsAtExit() {
+    if (!StageStats::dump(statsOutput)) {
+        std::cerr << "Не удалось записать статистику: " << statsOutput << "\n";
+    }
+}
+
+// Файл трассировки, записываемой при завершении программы
+std::string traceOutput;
+
+// Запись трассировки при завершении (регистрируется через std::atexit)
+void writeTraceAtExit() {
+    if (!TraceLog::write(traceOutput)) {
+        std::cerr << "Не удалось записать трассировку: " << traceOutput << "\n";
+    }
+}
+
+// Статистика стадий по запросу: JSON в консоль, при выключенном сборе - предложение включить
+void showStats() {
+    if (!StageStats::enabled()) {
+        std::cout << "\nСбор статистики выключен. Включить? (да/нет): ";
+        std::string choice;
+        std::getline(std::cin, choice);
+        
+        if (choice == "да" || choice == "yes" || choice == "y") {
+            StageStats::enable(true);
+            std::cout << "Сбор статистики включен\n";
+        }
+        return;
+    }
+    
+    std::cout << "\n" << StageStats::toJson();
+    
+    std::cout << "Сбросить счетчики? (да/нет): ";
+    std::string choice;
+    std::getline(std::cin, choice);
+    
+    if (choice == "да" || choice == "yes" || choice == "y") {
+        StageStats::reset();
+    }
+}
+
+// Справка по параметрам командной строки
+void printUsage(const char* program) {
+    std::cerr << "Использование:\n";
+    std::cerr << "  " << program << " [--threads N] [--stats FILE] [--trace FILE]   интерактивный режим\n";
+    std::cerr << "  " << program << " enc|dec --alg ALG (--key KEY | --key-file FILE) [параметры] < вход > выход\n";
+    std::cerr << "Параметры фильтра:\n";
+    std::cerr << "  --alg magma|trithemius|chacha20\n";
+    std::cerr << "  --mode ecb|ctr|cbc                  режим Магмы (по умолчанию ecb)\n";
+    std::cerr << "  --variant ietf|counter64|xchacha20  вариант ChaCha20 (по умолчанию ietf)\n";
+    std::cerr << "  --chunk N                           размер фрагмента в байтах (по умолчанию 1048576)\n";
+    std::cerr << "  --threads N                         число потоков шифрования\n";
+    std::cerr << "  --stats FILE                        статистика стадий в JSON при завершении (\"-\" - stderr)\n";
+    std::cerr << "  --trace FILE                        трассировка стадий и ядер для chrome://tracing и Perfetto\n";
+    std::cerr << "Переменная окружения RGR_KERNELS задает векторные ядра, например magma=ssse3,chacha20=avx2,trithemius=scalar\n";
+}
+
+// Разбор ключей командной строки: --name value или --name=value
+bool parseArguments(int argc, char* argv[], CommandLine& cmd) {
+    int first = 1;
+    
+    if (argc > 1 && (std::string(argv[1]) == "enc" || std::string(argv[1]) == "dec")) {
+        cmd.filter = true;
+        cmd.encrypt = std::string(argv[1]) == "enc";
+        first = 2;
+    }
+    
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string name = arg;
+        std::string value;
+        
+        size_t equals = arg.find('=');
+        if (arg.compare(0, 2, "--") == 0 && equals != std::string::npos) {
+            name = arg.substr(0, equals);
+            value = arg.substr(equals + 1);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            std::cerr << "Не задано значение параметра: " << arg << "\n";
+            return false;
+        }
+        
+        try {
+            if (name == "--threads" || name == "--chunk") {
+                size_t number = std::stoul(value);
+                if (number == 0) {
+                    throw std::invalid_argument(value);
+                }
+                
+                if (name == "--threads") {
+                    ThreadPool::setSharedThreads(number);
+                } else {
+                    cmd.chunkSize = number;
+                }
+            } else if (name == "--stats") {
+                cmd.statsPath = value;
+            } else if (name == "--trace") {
+                cmd.tracePath = value;
+            } else if (cmd.filter && name == "--alg") {
+                cmd.algorithm = value;
+            } else if (cmd.filter && name == "--mode") {
+                cmd.mode = value;
+            } else if (cmd.filter && name == "--variant") {
+                cmd.variant = value;
+            } else if (cmd.filter && name == "--key") {
+                cmd.key = value;
+            } else if (cmd.filter && name == "--key-file") {
+                cmd.keyFile = value;
+            } else {
+                std::cerr << "Неизвестный параметр: " << name << "\n";
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Неверное значение параметра " << name << ": " << value << "\n";
+            return false;
+        }
+    }
+    
+    if (cmd.filter && (cmd.algorithm.empty() || (cmd.key.empty() == cmd.keyFile.empty()))) {
+        std::cerr << "Для режима фильтра нужны --alg и один из параметров --key или --key-file\n";
+        return false;
+    }
+    
+    return true;
+}
+
+// Создание шифра по параметрам командной строки
+std::unique_ptr<ICipher> createFilterCipher(const CommandLine& cmd) {
+    if (cmd.algorithm == "magma") {
+        auto magma = std::make_unique<MagmaCipher>();
+        
+        if (cmd.mode.empty() || cmd.mode == "ecb") {
+            magma->setMode(MagmaCipher::Mode::ECB);
+        } else if (cmd.mode == "ctr") {
+            magma->setMode(MagmaCipher::Mode::CTR);
+        } else if (cmd.mode == "cbc") {
+            magma->setMode(MagmaCipher::Mode::CBC);
+        } else {
+            throw std::invalid_argument("Неизвестный режим Магмы: " + cmd.mode);
+        }
+        
+        return magma;
+    }
+    
+    if (cmd.algorithm == "trithemius") {
+        return std::make_unique<TrithemiusCipher>();
+    }
+    
+    if (cmd.algorithm == "chacha20") {
+        auto chacha = std::make_unique<ChaCha20Cipher>();
+        
+        if (cmd.variant.empty() || cmd.variant == "ietf") {
+            chacha->setVariant(ChaCha20Cipher::Variant::IETF);
+        } else if (cmd.variant == "counter64") {
+            chacha->setVariant(ChaCha20Cipher::Variant::Counter64);
+        } else if (cmd.variant == "xchacha20") {
+            chacha->setVariant(ChaCha20Cipher::Variant::XChaCha20);
+        } else {
+            throw std::invalid_argument("Неизвестный вариант ChaCha20: " + cmd.variant);
+        }
+        
+        return chacha;
+    }
+    
+    throw std::invalid_argument("Неизвестный алгоритм: " + cmd.algorithm);
+}
+
+// Режим фильтра: stdin -> stdout фрагментами фиксированного размера, без диалога.
+// В stdout выводятся только данные, сообщения - в stderr
+int runFilter(const CommandLine& cmd) {
+    try {
+        std::unique_ptr<ICipher> cipher = createFilterCipher(cmd);
+        
+        // Ключ из файла: завершающие пробелы и переводы строк отбрасываются
+        std::string key = cmd.key;
+        if (!cmd.keyFile.empty()) {
+            std::vector<uint8_t> keyData = FileHandler::readFile(cmd.keyFile);
+            key.assign(keyData.begin(), keyData.end());
+            
+            while (!key.empty() && std::isspace(static_cast<unsigned char>(key.back()))) {
+                key.pop_back();
+            }
+        }
+        
+        if (!cipher->validateKey(key)) {
+            throw std::invalid_argument("Неверный формат ключа. Ожидается: " + cipher->getKeyFormat());
+        }
+        
+#ifdef _WIN32
+        _setmode(0, _O_BINARY);
+        _setmode(1, _O_BINARY);
+#endif
+        
+        std::unique_ptr<ICipherStream> stream = cipher->createStream();
+        {
+            StageStats::Timer timer(StageStats::KeySetup);
+            stream->begin(key, cmd.encrypt);
+        }
+        FileHandler::processDescriptors(0, 1, *stream, cmd.chunkSize);
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    
+    return 0;
+}
+
 // Главная функция
-int main() {
+int main(int argc, char* argv[]) {
     // Установка локали для корректного отображения кириллицы
     std::setlocale(LC_ALL, "ru_RU.UTF-8");
     
+    CommandLine cmd;
+    
+    if (!parseArguments(argc, argv, cmd)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    // Сбор статистики стадий с записью при завершении
+    if (!cmd.statsPath.empty()) {
+        statsOutput = cmd.statsPath;
+        StageStats::enable(true);
+        std::atexit(dumpStatsAtExit);
+    }
+    
+    // Трассировка во времени с записью при завершении
+    if (!cmd.tracePath.empty()) {
+        traceOutput = cmd.tracePath;
+        TraceLog::setThreadName("main");
+        TraceLog::enable(true);
+        std::atexit(writeTraceAtExit);
+    }
+    
+    // Выбор и самопроверка векторных ядер до начала работы
+    for (const std::string& warning : KernelRegistry::warnings()) {
+        std::cerr << "Предупреждение: " << warning << "\n";
+    }
+    
+    if (cmd.filter) {
+        return runFilter(cmd);
+    }
+    
     std::cout << "Добро пожаловать в систему шифрования!\n";
     std::cout << "Программа разработана в соответствии с ГОСТ 19.201-78\n";
     
@@ -362,6 +1008,14 @@ int main() {
                     keyGenerator();
                     break;
                     
+                case 4:
+                    processDirectory();
+                    break;
+                    
+                case 5:
+                    showStats();
+                    break;
+                    
                 case 0:
                     std::cout << "\nЗавершение работы программы...\n";
                     std::cout << "До свидания!\n";
@@ -369,7 +1023,7 @@ int main() {
                     break;
                     
                 default:
-                    std::cout << "\nОшибка: неверный выбор! Пожалуйста, выберите пункт от 0 до 3.\n";
+                    std::cout << "\nОшибка: неверный выбор! Пожалуйста, выберите пункт от 0 до 5.\n";
             }
         } catch (const std::exception& e) {
             std::cout << "\nКритическая ошибка: " << e.what() << "\n";
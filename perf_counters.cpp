@@ -0,0 +1,157 @@
+#include "../include/perf_counters.h"
+#include <cstring>
+#include <cerrno>
+
+#ifdef RGR_PERF_EVENTS
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#ifdef RGR_PERF_EVENTS
+
+namespace {
+
+// Тип и конфигурация события perf
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+EventConfig eventConfig(PerfCounters::Event event) {
+    switch (event) {
+        case PerfCounters::Cycles:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+        case PerfCounters::Instructions:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+        case PerfCounters::L1dMisses:
+            return {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+        case PerfCounters::LlcMisses:
+            return {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+        default:
+            return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+    }
+}
+
+int openEvent(PerfCounters::Event event) {
+    EventConfig config = eventConfig(event);
+    
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = config.type;
+    attr.config = config.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+}
+
+PerfCounters::PerfCounters() {
+    for (int e = 0; e < EVENT_COUNT; e++) {
+        fds[e] = openEvent(static_cast<Event>(e));
+        
+        if (fds[e] < 0 && firstError.empty()) {
+            firstError = std::string(eventName(static_cast<Event>(e))) + ": " + std::strerror(errno);
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void PerfCounters::start() {
+    // Для унаследованных счетчиков ioctl применяется и к копиям в потоках
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfCounters::Values PerfCounters::stop() {
+    Values values;
+    
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    
+    for (int e = 0; e < EVENT_COUNT; e++) {
+        // value, time_enabled, time_running
+        uint64_t data[3];
+        
+        if (fds[e] < 0 || read(fds[e], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+            continue;
+        }
+        
+        values.valid[e] = true;
+        values.value[e] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    }
+    
+    return values;
+}
+
+#else
+
+PerfCounters::PerfCounters() : firstError("счетчики perf поддерживаются только в Linux") {
+    for (int& fd : fds) {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {}
+
+bool PerfCounters::available() const {
+    return false;
+}
+
+void PerfCounters::start() {}
+
+PerfCounters::Values PerfCounters::stop() {
+    return Values();
+}
+
+#endif
+
+const char* PerfCounters::eventName(Event event) {
+    switch (event) {
+        case Cycles:
+            return "cycles";
+        case Instructions:
+            return "instructions";
+        case L1dMisses:
+            return "l1d_misses";
+        case LlcMisses:
+            return "llc_misses";
+        default:
+            return "branch_misses";
+    }
+}
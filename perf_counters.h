@@ -0,0 +1,62 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Аппаратные счетчики производительности Linux (perf_event_open).
+// Счетчики могут быть недоступны (perf_event_paranoid, виртуальная машина без PMU,
+// другая ОС): такие события просто не считаются, измерения продолжаются без них
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/perf_event.h>)
+        #define RGR_PERF_EVENTS 1
+    #endif
+#endif
+
+class PerfCounters {
+public:
+    // Измеряемые события
+    enum Event {
+        Cycles,
+        Instructions,
+        L1dMisses,
+        LlcMisses,
+        BranchMisses,
+        EVENT_COUNT
+    };
+    
+    // Значения за интервал start/stop; valid[e] = false - событие недоступно
+    struct Values {
+        bool valid[EVENT_COUNT] = {};
+        double value[EVENT_COUNT] = {};
+    };
+    
+    // Открытие счетчиков для текущего процесса (только пользовательский режим).
+    // Потоки, созданные после открытия (общий пул), учитываются вместе с вызывающим
+    PerfCounters();
+    ~PerfCounters();
+    
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    
+    // Открыт ли хотя бы один счетчик
+    bool available() const;
+    
+    // Причина недоступности первого неоткрытого события (пусто, если открыты все)
+    const std::string& error() const { return firstError; }
+    
+    // Сброс и запуск счетчиков
+    void start();
+    
+    // Остановка и чтение; при мультиплексировании значения масштабируются на время работы счетчика
+    Values stop();
+    
+    // Имя события для отчета (cycles, instructions, l1d_misses, llc_misses, branch_misses)
+    static const char* eventName(Event event);
+
+private:
+    int fds[EVENT_COUNT];
+    std::string firstError;
+};
+
+#endif
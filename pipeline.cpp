@@ -0,0 +1,232 @@
+#include "../include/pipeline.h"
+#include "../include/spsc_ring.h"
+#include "../include/stage_stats.h"
+#include "../include/trace_log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Число попыток с уступкой процессора перед короткой паузой
+const int SPIN_LIMIT = 64;
+
+// Фрагмент пула: входной и выходной буферы переиспользуются между проходами
+struct Chunk {
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    size_t inputSize = 0;
+    size_t outputSize = 0;
+    bool last = false;
+};
+
+double elapsed(Clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+// Ожидание элемента очереди; false - конвейер остановлен из-за ошибки другой стадии
+bool waitPop(SpscRing<size_t>& ring, size_t& value, const std::atomic<bool>& failed) {
+    int spins = 0;
+    
+    while (!ring.tryPop(value)) {
+        if (failed.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        
+        if (++spins < SPIN_LIMIT) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    
+    return true;
+}
+
+// Очереди вмещают весь пул, поэтому добавление всегда успешно
+void push(SpscRing<size_t>& ring, size_t value) {
+    while (!ring.tryPush(value)) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+FilePipeline::FilePipeline(size_t chunkSize, size_t depth)
+    : chunkSize(std::max<size_t>(chunkSize, 1)), depth(std::max<size_t>(depth, 2)) {
+}
+
+FilePipeline::Stats FilePipeline::run(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream) {
+    // Выходной буфер вмещает наибольший вывод update и finish
+    std::vector<Chunk> chunks(depth);
+    for (Chunk& chunk : chunks) {
+        chunk.input.resize(chunkSize);
+        chunk.output.resize(stream.updateOutputSize(chunkSize) + stream.finishOutputSize());
+    }
+    
+    // Свободные фрагменты (запись -> чтение), прочитанные (чтение -> шифрование),
+    // зашифрованные (шифрование -> запись)
+    SpscRing<size_t> freeRing(depth);
+    SpscRing<size_t> readRing(depth);
+    SpscRing<size_t> cipherRing(depth);
+    
+    for (size_t i = 0; i < depth; i++) {
+        push(freeRing, i);
+    }
+    
+    std::atomic<bool> failed{false};
+    std::exception_ptr errors[3];
+    
+    Stats stats;
+    Clock::duration readerTime{};
+    Clock::duration cipherTime{};
+    Clock::duration writerTime{};
+    size_t readFillSum = 0;
+    size_t cipherFillSum = 0;
+    
+    Clock::time_point start = Clock::now();
+    
+    std::thread reader([&]() {
+        TraceLog::setThreadName("pipeline-read");
+        
+        try {
+            std::ifstream file(inputPath, std::ios::binary);
+            
+            if (!file) {
+                throw std::runtime_error("Не удалось открыть файл для чтения: " + inputPath);
+            }
+            
+            bool last = false;
+            size_t index;
+            
+            while (!last && waitPop(freeRing, index, failed)) {
+                Chunk& chunk = chunks[index];
+                Clock::time_point begin = Clock::now();
+                
+                file.read(reinterpret_cast<char*>(chunk.input.data()), static_cast<std::streamsize>(chunkSize));
+                
+                if (file.bad()) {
+                    throw std::runtime_error("Ошибка при чтении файла: " + inputPath);
+                }
+                
+                // Короткое чтение означает конец файла
+                chunk.inputSize = static_cast<size_t>(file.gcount());
+                chunk.last = last = !file;
+                
+                Clock::time_point end = Clock::now();
+                readerTime += end - begin;
+                StageStats::record(StageStats::Read, chunk.inputSize, begin, end);
+                stats.bytesRead += chunk.inputSize;
+                push(readRing, index);
+            }
+        } catch (...) {
+            errors[0] = std::current_exception();
+            failed = true;
+        }
+    });
+    
+    std::thread writer([&]() {
+        TraceLog::setThreadName("pipeline-write");
+        
+        try {
+            std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+            
+            if (!file) {
+                throw std::runtime_error("Не удалось открыть файл для записи: " + outputPath);
+            }
+            
+            bool last = false;
+            size_t index;
+            
+            while (!last && waitPop(cipherRing, index, failed)) {
+                cipherFillSum += cipherRing.size() + 1;
+                
+                Chunk& chunk = chunks[index];
+                Clock::time_point begin = Clock::now();
+                
+                file.write(reinterpret_cast<const char*>(chunk.output.data()), static_cast<std::streamsize>(chunk.outputSize));
+                last = chunk.last;
+                
+                if (last) {
+                    file.close();
+                }
+                
+                if (!file) {
+                    throw std::runtime_error("Ошибка при записи файла: " + outputPath);
+                }
+                
+                Clock::time_point end = Clock::now();
+                writerTime += end - begin;
+                StageStats::record(StageStats::Write, chunk.outputSize, begin, end);
+                stats.bytesWritten += chunk.outputSize;
+                push(freeRing, index);
+            }
+        } catch (...) {
+            errors[2] = std::current_exception();
+            failed = true;
+        }
+    });
+    
+    // Стадия шифрования выполняется в вызывающем потоке
+    try {
+        bool last = false;
+        size_t index;
+        
+        while (!last && waitPop(readRing, index, failed)) {
+            readFillSum += readRing.size() + 1;
+            
+            Chunk& chunk = chunks[index];
+            Clock::time_point begin = Clock::now();
+            
+            chunk.outputSize = stream.update(chunk.input.data(), chunk.inputSize, chunk.output.data());
+            last = chunk.last;
+            
+            if (last) {
+                chunk.outputSize += stream.finish(chunk.output.data() + chunk.outputSize);
+            }
+            
+            Clock::time_point end = Clock::now();
+            cipherTime += end - begin;
+            StageStats::record(StageStats::Cipher, chunk.inputSize, begin, end);
+            stats.chunks++;
+            push(cipherRing, index);
+        }
+    } catch (...) {
+        errors[1] = std::current_exception();
+        failed = true;
+    }
+    
+    reader.join();
+    writer.join();
+    
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            // Неполный результат не остается на диске
+            std::remove(outputPath.c_str());
+            std::rethrow_exception(error);
+        }
+    }
+    
+    stats.seconds = elapsed(Clock::now() - start);
+    
+    if (stats.seconds > 0) {
+        stats.readerBusy = elapsed(readerTime) / stats.seconds;
+        stats.cipherBusy = elapsed(cipherTime) / stats.seconds;
+        stats.writerBusy = elapsed(writerTime) / stats.seconds;
+    }
+    
+    if (stats.chunks > 0) {
+        stats.cipherQueueFill = static_cast<double>(readFillSum) / (stats.chunks * depth);
+        stats.writerQueueFill = static_cast<double>(cipherFillSum) / (stats.chunks * depth);
+    }
+    
+    return stats;
+}
@@ -0,0 +1,44 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "cipher_interface.h"
+#include <string>
+
+// Конвейер обработки файла: поток чтения, стадия шифрования и поток записи
+// работают одновременно и передают друг другу фрагменты из общего пула
+// через очереди без блокировок. Время обработки приближается к max(ввод-вывод, шифрование)
+class FilePipeline {
+public:
+    // Размер фрагмента и число фрагментов в пуле по умолчанию
+    static const size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+    static const size_t DEFAULT_DEPTH = 8;
+    
+    // Статистика выполнения
+    struct Stats {
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        size_t chunks = 0;
+        double seconds = 0;
+        
+        // Доля времени, занятая работой стадии (остальное - ожидание соседних стадий)
+        double readerBusy = 0;
+        double cipherBusy = 0;
+        double writerBusy = 0;
+        
+        // Средняя заполненность очередей перед шифрованием и перед записью (0..1)
+        double cipherQueueFill = 0;
+        double writerQueueFill = 0;
+    };
+    
+    explicit FilePipeline(size_t chunkSize = DEFAULT_CHUNK_SIZE, size_t depth = DEFAULT_DEPTH);
+    
+    // Обработка файла потоковым контекстом, для которого уже вызван begin.
+    // При ошибке любой стадии результирующий файл удаляется, исключение передается вызывающему
+    Stats run(const std::string& inputPath, const std::string& outputPath, ICipherStream& stream);
+
+private:
+    size_t chunkSize;
+    size_t depth;
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "../include/poly1305.h"
+#include <cstring>
+
+#ifdef __SIZEOF_INT128__
+
+__extension__ typedef unsigned __int128 uint128;
+
+namespace {
+
+uint64_t load64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+void store64(uint8_t* p, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+}
+
+Poly1305::Poly1305(const uint8_t* key) : leftover(0) {
+    uint64_t t0 = load64(key);
+    uint64_t t1 = load64(key + 8);
+    
+    // r с обнуленными по RFC 8439 битами (clamp)
+    r[0] = t0 & 0xffc0fffffffULL;
+    r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffULL;
+    r[2] = (t1 >> 24) & 0x00ffffffc0fULL;
+    
+    h[0] = h[1] = h[2] = 0;
+    
+    pad[0] = load64(key + 16);
+    pad[1] = load64(key + 24);
+}
+
+void Poly1305::blocks(const uint8_t* data, size_t length, bool final) {
+    const uint64_t hibit = final ? 0 : (1ULL << 40);
+    const uint64_t s1 = r[1] * (5 << 2);
+    const uint64_t s2 = r[2] * (5 << 2);
+    uint64_t h0 = h[0];
+    uint64_t h1 = h[1];
+    uint64_t h2 = h[2];
+    
+    while (length >= 16) {
+        uint64_t t0 = load64(data);
+        uint64_t t1 = load64(data + 8);
+        
+        // h += m
+        h0 += t0 & 0xfffffffffffULL;
+        h1 += ((t0 >> 44) | (t1 << 20)) & 0xfffffffffffULL;
+        h2 += ((t1 >> 24) & 0x3ffffffffffULL) | hibit;
+        
+        // h *= r (по модулю 2^130 - 5)
+        uint128 d0 = static_cast<uint128>(h0) * r[0] + static_cast<uint128>(h1) * s2 + static_cast<uint128>(h2) * s1;
+        uint128 d1 = static_cast<uint128>(h0) * r[1] + static_cast<uint128>(h1) * r[0] + static_cast<uint128>(h2) * s2;
+        uint128 d2 = static_cast<uint128>(h0) * r[2] + static_cast<uint128>(h1) * r[1] + static_cast<uint128>(h2) * r[0];
+        
+        // Частичное приведение
+        uint64_t c = static_cast<uint64_t>(d0 >> 44);
+        h0 = static_cast<uint64_t>(d0) & 0xfffffffffffULL;
+        d1 += c;
+        c = static_cast<uint64_t>(d1 >> 44);
+        h1 = static_cast<uint64_t>(d1) & 0xfffffffffffULL;
+        d2 += c;
+        c = static_cast<uint64_t>(d2 >> 42);
+        h2 = static_cast<uint64_t>(d2) & 0x3ffffffffffULL;
+        h0 += c * 5;
+        c = h0 >> 44;
+        h0 &= 0xfffffffffffULL;
+        h1 += c;
+        
+        data += 16;
+        length -= 16;
+    }
+    
+    h[0] = h0;
+    h[1] = h1;
+    h[2] = h2;
+}
+
+void Poly1305::finish(uint8_t* tag) {
+    // Последний неполный блок: 1 после данных и нули
+    if (leftover > 0) {
+        buffer[leftover] = 1;
+        std::memset(buffer + leftover + 1, 0, 16 - leftover - 1);
+        blocks(buffer, 16, true);
+    }
+    
+    uint64_t h0 = h[0];
+    uint64_t h1 = h[1];
+    uint64_t h2 = h[2];
+    
+    // Полное приведение
+    uint64_t c = h1 >> 44; h1 &= 0xfffffffffffULL;
+    h2 += c; c = h2 >> 42; h2 &= 0x3ffffffffffULL;
+    h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffffULL;
+    h1 += c; c = h1 >> 44; h1 &= 0xfffffffffffULL;
+    h2 += c; c = h2 >> 42; h2 &= 0x3ffffffffffULL;
+    h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffffULL;
+    h1 += c;
+    
+    // g = h + (-p)
+    uint64_t g0 = h0 + 5; c = g0 >> 44; g0 &= 0xfffffffffffULL;
+    uint64_t g1 = h1 + c; c = g1 >> 44; g1 &= 0xfffffffffffULL;
+    uint64_t g2 = h2 + c - (1ULL << 42);
+    
+    // Выбор h, если h < p, иначе g (без ветвлений)
+    c = (g2 >> 63) - 1;
+    g0 &= c;
+    g1 &= c;
+    g2 &= c;
+    c = ~c;
+    h0 = (h0 & c) | g0;
+    h1 = (h1 & c) | g1;
+    h2 = (h2 & c) | g2;
+    
+    // h = (h + pad) mod 2^128
+    uint64_t t0 = pad[0];
+    uint64_t t1 = pad[1];
+    h0 += t0 & 0xfffffffffffULL; c = h0 >> 44; h0 &= 0xfffffffffffULL;
+    h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffffULL) + c; c = h1 >> 44; h1 &= 0xfffffffffffULL;
+    h2 += ((t1 >> 24) & 0x3ffffffffffULL) + c; h2 &= 0x3ffffffffffULL;
+    
+    store64(tag, h0 | (h1 << 44));
+    store64(tag + 8, (h1 >> 20) | (h2 << 24));
+}
+
+#else
+
+namespace {
+
+uint32_t load32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void store32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+}
+
+Poly1305::Poly1305(const uint8_t* key) : leftover(0) {
+    // r с обнуленными по RFC 8439 битами (clamp)
+    r[0] = load32(key) & 0x3ffffff;
+    r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+    r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+    r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+    r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+    
+    h[0] = h[1] = h[2] = h[3] = h[4] = 0;
+    
+    for (int i = 0; i < 4; i++) {
+        pad[i] = load32(key + 16 + i * 4);
+    }
+}
+
+void Poly1305::blocks(const uint8_t* data, size_t length, bool final) {
+    const uint32_t hibit = final ? 0 : (1UL << 24);
+    const uint32_t s1 = r[1] * 5;
+    const uint32_t s2 = r[2] * 5;
+    const uint32_t s3 = r[3] * 5;
+    const uint32_t s4 = r[4] * 5;
+    uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+    
+    while (length >= 16) {
+        // h += m
+        h0 += load32(data) & 0x3ffffff;
+        h1 += (load32(data + 3) >> 2) & 0x3ffffff;
+        h2 += (load32(data + 6) >> 4) & 0x3ffffff;
+        h3 += (load32(data + 9) >> 6) & 0x3ffffff;
+        h4 += (load32(data + 12) >> 8) | hibit;
+        
+        // h *= r (по модулю 2^130 - 5)
+        uint64_t d0 = static_cast<uint64_t>(h0) * r[0] + static_cast<uint64_t>(h1) * s4 +
+                      static_cast<uint64_t>(h2) * s3 + static_cast<uint64_t>(h3) * s2 + static_cast<uint64_t>(h4) * s1;
+        uint64_t d1 = static_cast<uint64_t>(h0) * r[1] + static_cast<uint64_t>(h1) * r[0] +
+                      static_cast<uint64_t>(h2) * s4 + static_cast<uint64_t>(h3) * s3 + static_cast<uint64_t>(h4) * s2;
+        uint64_t d2 = static_cast<uint64_t>(h0) * r[2] + static_cast<uint64_t>(h1) * r[1] +
+                      static_cast<uint64_t>(h2) * r[0] + static_cast<uint64_t>(h3) * s4 + static_cast<uint64_t>(h4) * s3;
+        uint64_t d3 = static_cast<uint64_t>(h0) * r[3] + static_cast<uint64_t>(h1) * r[2] +
+                      static_cast<uint64_t>(h2) * r[1] + static_cast<uint64_t>(h3) * r[0] + static_cast<uint64_t>(h4) * s4;
+        uint64_t d4 = static_cast<uint64_t>(h0) * r[4] + static_cast<uint64_t>(h1) * r[3] +
+                      static_cast<uint64_t>(h2) * r[2] + static_cast<uint64_t>(h3) * r[1] + static_cast<uint64_t>(h4) * r[0];
+        
+        // Частичное приведение
+        uint32_t c = static_cast<uint32_t>(d0 >> 26); h0 = static_cast<uint32_t>(d0) & 0x3ffffff;
+        d1 += c; c = static_cast<uint32_t>(d1 >> 26); h1 = static_cast<uint32_t>(d1) & 0x3ffffff;
+        d2 += c; c = static_cast<uint32_t>(d2 >> 26); h2 = static_cast<uint32_t>(d2) & 0x3ffffff;
+        d3 += c; c = static_cast<uint32_t>(d3 >> 26); h3 = static_cast<uint32_t>(d3) & 0x3ffffff;
+        d4 += c; c = static_cast<uint32_t>(d4 >> 26); h4 = static_cast<uint32_t>(d4) & 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+        h1 += c;
+        
+        data += 16;
+        length -= 16;
+    }
+    
+    h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+}
+
+void Poly1305::finish(uint8_t* tag) {
+    // Последний неполный блок: 1 после данных и нули
+    if (leftover > 0) {
+        buffer[leftover] = 1;
+        std::memset(buffer + leftover + 1, 0, 16 - leftover - 1);
+        blocks(buffer, 16, true);
+    }
+    
+    uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+    
+    // Полное приведение
+    uint32_t c = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+    
+    // g = h + (-p)
+    uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    uint32_t g4 = h4 + c - (1UL << 26);
+    
+    // Выбор h, если h < p, иначе g (без ветвлений)
+    uint32_t mask = (g4 >> 31) - 1;
+    g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+    
+    // h = h % 2^128
+    h0 = (h0 | (h1 << 26)) & 0xffffffff;
+    h1 = ((h1 >> 6) | (h2 << 20)) & 0xffffffff;
+    h2 = ((h2 >> 12) | (h3 << 14)) & 0xffffffff;
+    h3 = ((h3 >> 18) | (h4 << 8)) & 0xffffffff;
+    
+    // h = (h + pad) mod 2^128
+    uint64_t f = static_cast<uint64_t>(h0) + pad[0]; h0 = static_cast<uint32_t>(f);
+    f = static_cast<uint64_t>(h1) + pad[1] + (f >> 32); h1 = static_cast<uint32_t>(f);
+    f = static_cast<uint64_t>(h2) + pad[2] + (f >> 32); h2 = static_cast<uint32_t>(f);
+    f = static_cast<uint64_t>(h3) + pad[3] + (f >> 32); h3 = static_cast<uint32_t>(f);
+    
+    store32(tag, h0);
+    store32(tag + 4, h1);
+    store32(tag + 8, h2);
+    store32(tag + 12, h3);
+}
+
+#endif
+
+void Poly1305::update(const uint8_t* data, size_t length) {
+    // Дополнение незавершенного блока
+    if (leftover > 0) {
+        size_t take = 16 - leftover;
+        if (take > length) {
+            take = length;
+        }
+        
+        std::memcpy(buffer + leftover, data, take);
+        leftover += take;
+        data += take;
+        length -= take;
+        
+        if (leftover < 16) {
+            return;
+        }
+        
+        blocks(buffer, 16, false);
+        leftover = 0;
+    }
+    
+    // Целые блоки напрямую из входных данных
+    size_t full = length & ~static_cast<size_t>(15);
+    if (full > 0) {
+        blocks(data, full, false);
+        data += full;
+        length -= full;
+    }
+    
+    if (length > 0) {
+        std::memcpy(buffer, data, length);
+        leftover = length;
+    }
+}
+
+void Poly1305::padToBlock() {
+    if (leftover > 0) {
+        std::memset(buffer + leftover, 0, 16 - leftover);
+        blocks(buffer, 16, false);
+        leftover = 0;
+    }
+}
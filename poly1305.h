@@ -0,0 +1,46 @@
+#ifndef POLY1305_H
+#define POLY1305_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Одноразовый аутентификатор Poly1305 (RFC 8439).
+// При наличии 128-битного умножения используются 64-битные конечности (3 x 44 бита),
+// иначе - 32-битные (5 x 26 бит)
+class Poly1305 {
+public:
+    // Размер ключа и тега в байтах
+    static const int KEY_SIZE = 32;
+    static const int TAG_SIZE = 16;
+    
+    explicit Poly1305(const uint8_t* key);
+    
+    // Добавление данных (произвольными порциями)
+    void update(const uint8_t* data, size_t length);
+    
+    // Дополнение нулями до границы 16 байт (для AEAD)
+    void padToBlock();
+    
+    // Завершение и получение тега
+    void finish(uint8_t* tag);
+
+private:
+    // Обработка целых 16-байтных блоков; final - последний неполный блок уже дополнен
+    void blocks(const uint8_t* data, size_t length, bool final);
+    
+#ifdef __SIZEOF_INT128__
+    uint64_t r[3];
+    uint64_t h[3];
+    uint64_t pad[2];
+#else
+    uint32_t r[5];
+    uint32_t h[5];
+    uint32_t pad[4];
+#endif
+    
+    // Незавершенный блок
+    uint8_t buffer[16];
+    size_t leftover;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Ограниченная очередь без блокировок для одного производителя и одного потребителя.
+// Емкость округляется вверх до степени двойки; индексы растут монотонно,
+// позиция в массиве - младшие биты индекса
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        
+        slots.resize(size);
+        mask = size - 1;
+    }
+    
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    
+    // Добавление элемента (только поток-производитель); false - очередь заполнена
+    bool tryPush(const T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        
+        if (position - head.load(std::memory_order_acquire) > mask) {
+            return false;
+        }
+        
+        slots[position & mask] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Извлечение элемента (только поток-потребитель); false - очередь пуста
+    bool tryPop(T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        
+        if (position == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        
+        value = slots[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Текущее число элементов (приблизительно, если очередь используется другими потоками)
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    
+    size_t capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    
+    // Индексы потребителя и производителя в разных строках кэша
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "../include/stage_stats.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+// Счетчики одной стадии (число выполнений - сумма гистограммы)
+struct StageCounters {
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::atomic<uint64_t> histogram[StageStats::HISTOGRAM_BUCKETS] = {};
+};
+
+StageCounters counters[StageStats::STAGE_COUNT];
+
+// Номер интервала гистограммы: число значащих бит задержки
+int bucketIndex(uint64_t ns) {
+    int bucket = 0;
+    
+    while (ns != 0 && bucket < StageStats::HISTOGRAM_BUCKETS - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+    
+    return bucket;
+}
+
+// Верхняя граница интервала в наносекундах
+uint64_t bucketLimit(int bucket) {
+    return uint64_t(1) << bucket;
+}
+
+// Оценка процентиля по гистограмме (верхняя граница интервала)
+uint64_t percentile(const uint64_t* histogram, uint64_t calls, double fraction) {
+    uint64_t rank = static_cast<uint64_t>(static_cast<double>(calls) * fraction);
+    uint64_t seen = 0;
+    
+    for (int i = 0; i < StageStats::HISTOGRAM_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > rank) {
+            return bucketLimit(i);
+        }
+    }
+    
+    return bucketLimit(StageStats::HISTOGRAM_BUCKETS - 1);
+}
+
+}
+
+std::atomic<bool> StageStats::active{false};
+
+void StageStats::enable(bool on) {
+    active.store(on, std::memory_order_relaxed);
+}
+
+void StageStats::record(Stage stage, uint64_t bytes, std::chrono::steady_clock::time_point begin,
+                        std::chrono::steady_clock::time_point end) {
+    TraceLog::complete(stageName(stage), "stage", begin, end, bytes);
+    
+    if (!enabled()) {
+        return;
+    }
+    
+    uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    StageCounters& c = counters[stage];
+    
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    c.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    c.histogram[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    
+    uint64_t previous = c.maxNs.load(std::memory_order_relaxed);
+    while (ns > previous && !c.maxNs.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void StageStats::reset() {
+    for (StageCounters& c : counters) {
+        c.bytes = 0;
+        c.totalNs = 0;
+        c.maxNs = 0;
+        
+        for (auto& bucket : c.histogram) {
+            bucket = 0;
+        }
+    }
+}
+
+std::string StageStats::toJson() {
+    std::ostringstream out;
+    out << std::fixed;
+    out << "{\n  \"enabled\": " << (enabled() ? "true" : "false") << ",\n  \"stages\": {";
+    
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const StageCounters& c = counters[s];
+        
+        // Снимок: стадии в других потоках могут продолжаться, значения согласованы приближенно
+        uint64_t histogram[HISTOGRAM_BUCKETS];
+        uint64_t calls = 0;
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            histogram[i] = c.histogram[i].load(std::memory_order_relaxed);
+            calls += histogram[i];
+        }
+        uint64_t bytes = c.bytes.load(std::memory_order_relaxed);
+        uint64_t totalNs = c.totalNs.load(std::memory_order_relaxed);
+        
+        out << (s > 0 ? "," : "") << "\n    \"" << stageName(static_cast<Stage>(s)) << "\": {"
+            << "\"calls\": " << calls << ", \"bytes\": " << bytes << ", \"total_ns\": " << totalNs
+            << ", \"max_ns\": " << c.maxNs.load(std::memory_order_relaxed);
+        
+        if (calls > 0) {
+            out << std::setprecision(1) << ", \"mean_ns\": " << static_cast<double>(totalNs) / static_cast<double>(calls)
+                << ", \"p50_ns\": " << percentile(histogram, calls, 0.5)
+                << ", \"p99_ns\": " << percentile(histogram, calls, 0.99);
+        }
+        
+        if (bytes > 0 && totalNs > 0) {
+            out << std::setprecision(2) << ", \"mb_per_s\": " << static_cast<double>(bytes) * 1e3 / static_cast<double>(totalNs);
+        }
+        
+        // Только непустые интервалы: le_ns - верхняя граница интервала
+        out << ", \"histogram\": [";
+        bool first = true;
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            if (histogram[i] == 0) {
+                continue;
+            }
+            
+            out << (first ? "" : ", ") << "{\"le_ns\": " << bucketLimit(i) << ", \"count\": " << histogram[i] << "}";
+            first = false;
+        }
+        out << "]}";
+    }
+    
+    out << "\n  }\n}\n";
+    return out.str();
+}
+
+bool StageStats::dump(const std::string& path) {
+    std::string json = toJson();
+    
+    if (path == "-") {
+        std::cerr << json;
+        return static_cast<bool>(std::cerr);
+    }
+    
+    std::ofstream file(path);
+    
+    if (!file) {
+        return false;
+    }
+    
+    file << json;
+    file.close();
+    return static_cast<bool>(file);
+}
+
+const char* StageStats::stageName(Stage stage) {
+    switch (stage) {
+        case Read:
+            return "read";
+        case KeySetup:
+            return "key_setup";
+        case Cipher:
+            return "cipher";
+        case Write:
+            return "write";
+        default:
+            return "unknown";
+    }
+}
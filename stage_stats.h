@@ -0,0 +1,84 @@
+#ifndef STAGE_STATS_H
+#define STAGE_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "trace_log.h"
+
+// Счетчики стадий обработки файлов: число выполнений, байты, суммарное и наибольшее время,
+// гистограмма задержек по степеням двойки. Счетчики общие для всех потоков (атомарные).
+// При включенной трассировке стадии также записываются в TraceLog.
+// По умолчанию сбор выключен: замер стадии стоит проверки двух флагов
+class StageStats {
+public:
+    // Стадии обработки
+    enum Stage {
+        Read,       // чтение файла или фрагмента
+        KeySetup,   // разбор и развертывание ключа
+        Cipher,     // шифрование или дешифрование (с отображением в память - вместе с подкачкой страниц)
+        Write,      // запись файла или фрагмента
+        STAGE_COUNT
+    };
+    
+    // Интервалы гистограммы: в интервал i попадают задержки [2^(i-1), 2^i) нс, в последний - все большие
+    static const int HISTOGRAM_BUCKETS = 40;
+    
+    // Включение и выключение сбора (накопленные значения сохраняются)
+    static void enable(bool on);
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    
+    // Нужны ли замеры стадий: включен сбор статистики или трассировка
+    static bool measuring() { return enabled() || TraceLog::enabled(); }
+    
+    // Учет одного выполнения стадии в статистике и трассировке (что из них включено)
+    static void record(Stage stage, uint64_t bytes, std::chrono::steady_clock::time_point begin,
+                       std::chrono::steady_clock::time_point end);
+    
+    // Обнуление счетчиков
+    static void reset();
+    
+    // Текущие значения в JSON
+    static std::string toJson();
+    
+    // Запись JSON в файл ("-" - в stderr); false при ошибке записи
+    static bool dump(const std::string& path);
+    
+    // Название стадии в JSON
+    static const char* stageName(Stage stage);
+    
+    // Замер стадии в пределах области видимости (монотонные часы).
+    // Если сбор и трассировка выключены при создании, часы не читаются
+    class Timer {
+    public:
+        explicit Timer(Stage stage, uint64_t bytes = 0) : stage(stage), bytes(bytes), running(measuring()) {
+            if (running) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        
+        ~Timer() {
+            if (running) {
+                record(stage, bytes, start, std::chrono::steady_clock::now());
+            }
+        }
+        
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+        
+        // Объем данных, если он известен только после выполнения стадии
+        void setBytes(uint64_t count) { bytes = count; }
+    
+    private:
+        Stage stage;
+        uint64_t bytes;
+        bool running;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    static std::atomic<bool> active;
+};
+
+#endif
@@ -0,0 +1,399 @@
+#include "../include/text_codec.h"
+#include "../include/cpu_features.h"
+#include <stdexcept>
+#include <cstring>
+
+#ifdef RGR_X86_SIMD
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+int base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+    return -1;
+}
+
+[[noreturn]] void invalidCharacter(const char* encoding, size_t position) {
+    throw std::invalid_argument(std::string("Недопустимый символ ") + encoding +
+                                " в позиции " + std::to_string(position));
+}
+
+#ifdef RGR_X86_SIMD
+
+// Значения 16 hex символов; в valid - маска корректных символов
+__attribute__((target("sse2")))
+inline __m128i hexNibbles(__m128i chars, __m128i& valid) {
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    
+    // Приведение к нижнему регистру: 'A'..'F' -> 'a'..'f', цифры не меняются
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    
+    valid = _mm_or_si128(isDigit, isLetter);
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+// Маска байт из диапазона [low, high] (символы старше 127 отрицательны и в диапазон не попадают)
+__attribute__((target("sse2")))
+inline __m128i inRange(__m128i chars, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(low - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(high + 1)), chars));
+}
+
+#endif
+
+}
+
+std::string TextCodec::encode(const uint8_t* data, size_t length, TextEncoding encoding) {
+    std::string result;
+    
+    switch (encoding) {
+        case TextEncoding::Raw:
+            result.assign(reinterpret_cast<const char*>(data), length);
+            break;
+        case TextEncoding::Hex:
+            result.resize(length * 2);
+            encodeHex(data, length, &result[0]);
+            break;
+        case TextEncoding::Base64:
+            result.resize((length + 2) / 3 * 4);
+            encodeBase64(data, length, &result[0]);
+            break;
+    }
+    
+    return result;
+}
+
+std::string TextCodec::encode(const std::vector<uint8_t>& data, TextEncoding encoding) {
+    return encode(data.data(), data.size(), encoding);
+}
+
+std::vector<uint8_t> TextCodec::decode(const std::string& text, TextEncoding encoding) {
+    std::vector<uint8_t> result;
+    
+    switch (encoding) {
+        case TextEncoding::Raw:
+            result.assign(text.begin(), text.end());
+            break;
+        case TextEncoding::Hex:
+            if (text.length() % 2 != 0) {
+                throw std::invalid_argument("Длина hex строки должна быть четной");
+            }
+            result.resize(text.length() / 2);
+            decodeHex(text.data(), text.length(), result.data());
+            break;
+        case TextEncoding::Base64: {
+            if (text.length() % 4 != 0) {
+                throw std::invalid_argument("Длина base64 строки должна быть кратна 4");
+            }
+            
+            size_t padding = 0;
+            if (!text.empty() && text[text.length() - 1] == '=') {
+                padding = text[text.length() - 2] == '=' ? 2 : 1;
+            }
+            
+            result.resize(text.length() / 4 * 3 - padding);
+            decodeBase64(text.data(), text.length(), result.data());
+            break;
+        }
+    }
+    
+    return result;
+}
+
+std::string TextCodec::encodingName(TextEncoding encoding) {
+    switch (encoding) {
+        case TextEncoding::Raw:
+            return "без кодирования";
+        case TextEncoding::Hex:
+            return "hex";
+        case TextEncoding::Base64:
+            return "base64";
+    }
+    
+    return "";
+}
+
+void TextCodec::encodeHex(const uint8_t* data, size_t length, char* output) {
+    size_t done = CpuFeatures::hasSse2() ? encodeHexSse2(data, length, output) : 0;
+    
+    for (size_t i = done; i < length; i++) {
+        output[2 * i] = HEX_DIGITS[data[i] >> 4];
+        output[2 * i + 1] = HEX_DIGITS[data[i] & 0x0F];
+    }
+}
+
+void TextCodec::decodeHex(const char* text, size_t length, uint8_t* output) {
+    size_t done = CpuFeatures::hasSse2() ? decodeHexSse2(text, length, output) : 0;
+    
+    // Хвост; здесь же определяется позиция первого некорректного символа
+    for (size_t i = done; i < length; i += 2) {
+        int high = hexValue(text[i]);
+        if (high < 0) {
+            invalidCharacter("hex", i);
+        }
+        
+        int low = hexValue(text[i + 1]);
+        if (low < 0) {
+            invalidCharacter("hex", i + 1);
+        }
+        
+        output[i / 2] = static_cast<uint8_t>((high << 4) | low);
+    }
+}
+
+void TextCodec::encodeBase64(const uint8_t* data, size_t length, char* output) {
+    size_t done = CpuFeatures::hasSsse3() ? encodeBase64Ssse3(data, length, output) : 0;
+    char* out = output + done / 3 * 4;
+    size_t i = done;
+    
+    for (; i + 3 <= length; i += 3) {
+        uint32_t triple = (static_cast<uint32_t>(data[i]) << 16) | (data[i + 1] << 8) | data[i + 2];
+        *out++ = BASE64_ALPHABET[(triple >> 18) & 0x3F];
+        *out++ = BASE64_ALPHABET[(triple >> 12) & 0x3F];
+        *out++ = BASE64_ALPHABET[(triple >> 6) & 0x3F];
+        *out++ = BASE64_ALPHABET[triple & 0x3F];
+    }
+    
+    // Неполная группа дополняется '='
+    if (i < length) {
+        uint32_t triple = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < length) {
+            triple |= data[i + 1] << 8;
+        }
+        
+        *out++ = BASE64_ALPHABET[(triple >> 18) & 0x3F];
+        *out++ = BASE64_ALPHABET[(triple >> 12) & 0x3F];
+        *out++ = i + 1 < length ? BASE64_ALPHABET[(triple >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+}
+
+void TextCodec::decodeBase64(const char* text, size_t length, uint8_t* output) {
+    if (length == 0) {
+        return;
+    }
+    
+    // Последняя группа может содержать дополнение, поэтому векторно обрабатываются только предыдущие
+    size_t done = CpuFeatures::hasSsse3() ? decodeBase64Ssse3(text, length - 4, output) : 0;
+    uint8_t* out = output + done / 4 * 3;
+    
+    for (size_t i = done; i < length; i += 4) {
+        bool last = i + 4 == length;
+        uint32_t quad = 0;
+        size_t padding = 0;
+        
+        for (size_t j = 0; j < 4; j++) {
+            char c = text[i + j];
+            int value;
+            
+            // '=' допустим только в двух последних позициях последней группы и только в конце
+            if (c == '=' && last && j >= 2 && (j == 3 || text[i + 3] == '=')) {
+                value = 0;
+                padding++;
+            } else {
+                value = base64Value(c);
+                if (value < 0) {
+                    invalidCharacter("base64", i + j);
+                }
+            }
+            
+            quad = (quad << 6) | static_cast<uint32_t>(value);
+        }
+        
+        // Строгая проверка: отброшенные дополнением биты должны быть нулевыми
+        if ((padding == 1 && (quad & 0xFF) != 0) || (padding == 2 && (quad & 0xFFFF) != 0)) {
+            throw std::invalid_argument("Ненулевые биты перед дополнением base64 в позиции " +
+                                        std::to_string(i));
+        }
+        
+        *out++ = static_cast<uint8_t>(quad >> 16);
+        if (padding < 2) {
+            *out++ = static_cast<uint8_t>(quad >> 8);
+        }
+        if (padding < 1) {
+            *out++ = static_cast<uint8_t>(quad);
+        }
+    }
+}
+
+#ifdef RGR_X86_SIMD
+
+__attribute__((target("sse2")))
+size_t TextCodec::encodeHexSse2(const uint8_t* data, size_t length, char* output) {
+    size_t processed = length - length % HEX_ENCODE_WIDTH;
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i digitBase = _mm_set1_epi8('0');
+    const __m128i letterGap = _mm_set1_epi8('a' - '0' - 10);
+    
+    for (size_t i = 0; i < processed; i += HEX_ENCODE_WIDTH) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibbleMask);
+        __m128i low = _mm_and_si128(bytes, nibbleMask);
+        
+        // Тетрада -> символ: '0' + n, для n > 9 добавляется разрыв до 'a'
+        high = _mm_add_epi8(_mm_add_epi8(high, digitBase), _mm_and_si128(_mm_cmpgt_epi8(high, nine), letterGap));
+        low = _mm_add_epi8(_mm_add_epi8(low, digitBase), _mm_and_si128(_mm_cmpgt_epi8(low, nine), letterGap));
+        
+        // Чередование: старшая тетрада, затем младшая
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+    
+    return processed;
+}
+
+__attribute__((target("sse2")))
+size_t TextCodec::decodeHexSse2(const char* text, size_t length, uint8_t* output) {
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+    size_t i = 0;
+    
+    for (; i + HEX_DECODE_WIDTH <= length; i += HEX_DECODE_WIDTH) {
+        __m128i validFirst;
+        __m128i validSecond;
+        __m128i first = hexNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), validFirst);
+        __m128i second = hexNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 16)), validSecond);
+        
+        if (_mm_movemask_epi8(_mm_and_si128(validFirst, validSecond)) != 0xFFFF) {
+            break;
+        }
+        
+        // В каждом 16-битном слове: младший байт - старшая тетрада, старший байт - младшая
+        first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, lowByte), 4), _mm_srli_epi16(first, 8));
+        second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, lowByte), 4), _mm_srli_epi16(second, 8));
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i / 2), _mm_packus_epi16(first, second));
+    }
+    
+    return i;
+}
+
+__attribute__((target("ssse3")))
+size_t TextCodec::encodeBase64Ssse3(const uint8_t* data, size_t length, char* output) {
+    // Сдвиг символа относительно индекса для каждой группы алфавита
+    const __m128i shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    char* out = output;
+    
+    // Загружается 16 байт, используется 12: последняя итерация не должна выходить за данные
+    for (; i + 16 <= length; i += BASE64_ENCODE_WIDTH) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        
+        // Каждая тройка s0 s1 s2 раскладывается в слово [s1 s0 s2 s1]
+        bytes = _mm_shuffle_epi8(bytes, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        
+        // Выделение четырех 6-битных индексов в отдельные байты умножениями на степени двойки
+        __m128i ac = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        __m128i bd = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(ac, bd);
+        
+        // Номер группы: 0 - 'a'..'z', 1..10 - цифры, 11 - '+', 12 - '/', 13 - 'A'..'Z'
+        __m128i group = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        group = _mm_or_si128(group, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        
+        __m128i chars = _mm_add_epi8(indices, _mm_shuffle_epi8(shiftLut, group));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+        out += 16;
+    }
+    
+    return i;
+}
+
+__attribute__((target("ssse3")))
+size_t TextCodec::decodeBase64Ssse3(const char* text, size_t length, uint8_t* output) {
+    size_t i = 0;
+    uint8_t* out = output;
+    
+    for (; i + BASE64_DECODE_WIDTH <= length; i += BASE64_DECODE_WIDTH) {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        
+        __m128i upper = inRange(chars, 'A', 'Z');
+        __m128i lower = inRange(chars, 'a', 'z');
+        __m128i digit = inRange(chars, '0', '9');
+        __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+        __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        
+        __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+        if (_mm_movemask_epi8(valid) != 0xFFFF) {
+            break;
+        }
+        
+        // Символ -> 6-битное значение прибавлением смещения своей группы
+        __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+        offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+        offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+        offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+        offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+        __m128i values = _mm_add_epi8(chars, offset);
+        
+        // Слияние: пары в 12 бит, четверки в 24 бита, затем байты тройки в порядке старший-младший
+        __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        __m128i bytes = _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        
+        // Запись ровно 12 байт результата
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+        uint32_t tail = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+        std::memcpy(out + 8, &tail, sizeof(tail));
+        out += 12;
+    }
+    
+    return i;
+}
+
+#else
+
+size_t TextCodec::encodeHexSse2(const uint8_t*, size_t, char*) {
+    return 0;
+}
+
+size_t TextCodec::decodeHexSse2(const char*, size_t, uint8_t*) {
+    return 0;
+}
+
+size_t TextCodec::encodeBase64Ssse3(const uint8_t*, size_t, char*) {
+    return 0;
+}
+
+size_t TextCodec::decodeBase64Ssse3(const char*, size_t, uint8_t*) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef TEXT_CODEC_H
+#define TEXT_CODEC_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Текстовое представление шифртекста в encrypt/decrypt
+enum class TextEncoding {
+    Raw,     // байты без преобразования
+    Hex,     // 2 символа на байт (строчные при кодировании, любой регистр при декодировании)
+    Base64   // RFC 4648 с дополнением '=': 4 символа на 3 байта
+};
+
+// Кодирование и декодирование hex/base64: векторные ядра (SSE2/SSSE3)
+// обрабатывают основную часть, хвост и некорректные символы - скалярный код.
+// Декодирование строгое: любой посторонний символ, в том числе пробел, - исключение
+class TextCodec {
+public:
+    // Кодирование байт в выбранное представление
+    static std::string encode(const uint8_t* data, size_t length, TextEncoding encoding);
+    static std::string encode(const std::vector<uint8_t>& data, TextEncoding encoding);
+    
+    // Декодирование; при нарушении формата - std::invalid_argument с позицией символа
+    static std::vector<uint8_t> decode(const std::string& text, TextEncoding encoding);
+    
+    // Название кодировки для меню и сообщений
+    static std::string encodingName(TextEncoding encoding);
+
+private:
+    // Байт входа за итерацию ядер
+    static const int HEX_ENCODE_WIDTH = 16;
+    static const int BASE64_ENCODE_WIDTH = 12;
+    
+    // Символов входа за итерацию ядер
+    static const int HEX_DECODE_WIDTH = 32;
+    static const int BASE64_DECODE_WIDTH = 16;
+    
+    static void encodeHex(const uint8_t* data, size_t length, char* output);
+    static void decodeHex(const char* text, size_t length, uint8_t* output);
+    static void encodeBase64(const uint8_t* data, size_t length, char* output);
+    static void decodeBase64(const char* text, size_t length, uint8_t* output);
+    
+    // Векторные ядра возвращают число обработанных байт (символов) входа.
+    // Ядра декодирования останавливаются перед итерацией с некорректным символом
+    static size_t encodeHexSse2(const uint8_t* data, size_t length, char* output);
+    static size_t decodeHexSse2(const char* text, size_t length, uint8_t* output);
+    static size_t encodeBase64Ssse3(const uint8_t* data, size_t length, char* output);
+    static size_t decodeBase64Ssse3(const char* text, size_t length, uint8_t* output);
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "../include/thread_pool.h"
+#include "../include/trace_log.h"
+#include <algorithm>
+#include <exception>
+#include <string>
+
+// Набор задач одного вызова parallelFor
+struct ThreadPool::Batch {
+    const std::function<void(size_t)>* task;
+    size_t remaining;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+size_t ThreadPool::sharedThreads = 0;
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    // Вызывающий поток - один из threads
+    for (size_t i = 1; i < threads; i++) {
+        queues.emplace_back(new Queue);
+    }
+    
+    for (size_t i = 0; i < queues.size(); i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(sharedThreads);
+    return pool;
+}
+
+void ThreadPool::setSharedThreads(size_t threads) {
+    sharedThreads = threads;
+}
+
+bool ThreadPool::takeTask(size_t home, Task& task) {
+    for (size_t i = 0; i < queues.size(); i++) {
+        Queue& queue = *queues[(home + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        
+        if (i == 0) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        
+        std::lock_guard<std::mutex> sleepLock(sleepMutex);
+        pending--;
+        return true;
+    }
+    
+    return false;
+}
+
+void ThreadPool::runTask(const Task& task) {
+    Batch* batch = task.batch;
+    std::exception_ptr error;
+    
+    try {
+        (*batch->task)(task.index);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    
+    // Последнее обращение к batch - под его мьютексом: после уведомления вызывающий может его удалить
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    
+    if (error && !batch->error) {
+        batch->error = error;
+    }
+    
+    if (--batch->remaining == 0) {
+        batch->done.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(size_t id) {
+    Task task;
+    TraceLog::setThreadName("pool-" + std::to_string(id));
+    
+    while (true) {
+        if (takeTask(id, task)) {
+            runTask(task);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || pending > 0; });
+        
+        if (stopping && pending == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    
+    if (workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+    
+    Batch batch;
+    batch.task = &task;
+    batch.remaining = count;
+    
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        pending += count;
+    }
+    
+    // Задачи распределяются по очередям по кругу
+    for (size_t q = 0; q < queues.size(); q++) {
+        std::lock_guard<std::mutex> lock(queues[q]->mutex);
+        
+        for (size_t i = q; i < count; i += queues.size()) {
+            queues[q]->tasks.push_back(Task{&batch, i});
+        }
+    }
+    
+    wake.notify_all();
+    
+    // Вызывающий поток забирает задачи, пока они есть
+    Task stolen;
+    while (takeTask(0, stolen)) {
+        runTask(stolen);
+    }
+    
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+    
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
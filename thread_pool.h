@@ -0,0 +1,86 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач: у каждого рабочего потока своя очередь,
+// владелец берет задачи с конца, простаивающие потоки забирают их с начала чужих очередей.
+// Вызывающий поток участвует в выполнении, поэтому вложенные вызовы не блокируются
+class ThreadPool {
+public:
+    // threads - общее число потоков вместе с вызывающим (0 - по числу ядер)
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Общее число потоков вместе с вызывающим
+    size_t size() const { return workers.size() + 1; }
+    
+    // Выполнение task(i) для всех i из [0, count) с ожиданием завершения.
+    // Первое исключение из задач передается вызывающему после завершения остальных
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+    
+    // Разбиение диапазона [0, total) на фрагменты по grain элементов: func(begin, end)
+    template <typename Func>
+    void parallelRange(size_t total, size_t grain, Func func) {
+        size_t chunks = grain == 0 ? 1 : (total + grain - 1) / grain;
+        
+        if (chunks <= 1 || workers.empty()) {
+            func(size_t(0), total);
+            return;
+        }
+        
+        parallelFor(chunks, [&](size_t i) {
+            func(i * grain, std::min(total, (i + 1) * grain));
+        });
+    }
+    
+    // Общий пул процесса, создается при первом обращении
+    static ThreadPool& shared();
+    
+    // Число потоков общего пула (ключ --threads); действует, если задано до первого обращения к shared()
+    static void setSharedThreads(size_t threads);
+
+private:
+    struct Batch;
+    
+    struct Task {
+        Batch* batch;
+        size_t index;
+    };
+    
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    // Своя очередь (с конца), затем чужие (с начала)
+    bool takeTask(size_t home, Task& task);
+    
+    static void runTask(const Task& task);
+    
+    void workerLoop(size_t id);
+    
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    
+    // Число задач в очередях; простаивающие потоки ждут его увеличения
+    size_t pending = 0;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    
+    static size_t sharedThreads;
+};
+
+#endif
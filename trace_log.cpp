@@ -0,0 +1,176 @@
+#include "../include/trace_log.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using Clock = TraceLog::Clock;
+
+// Завершенный интервал
+struct Event {
+    const char* name;
+    const char* category;
+    const char* kernel;
+    uint64_t bytes;
+    Clock::time_point begin;
+    Clock::time_point end;
+};
+
+// Буфер одного потока: события добавляет только владелец. Число событий публикуется
+// после записи события (release), читатель видит только полностью записанные события
+struct ThreadBuffer {
+    std::atomic<Event*> blocks[TraceLog::MAX_BLOCKS] = {};
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    uint32_t tid = 0;
+    std::string name;
+    
+    ~ThreadBuffer() {
+        for (auto& block : blocks) {
+            delete[] block.load();
+        }
+    }
+    
+    void append(const Event& event) {
+        size_t n = count.load(std::memory_order_relaxed);
+        size_t block = n / TraceLog::BLOCK_EVENTS;
+        
+        if (block == TraceLog::MAX_BLOCKS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
+        Event* events = blocks[block].load(std::memory_order_relaxed);
+        if (!events) {
+            events = new Event[TraceLog::BLOCK_EVENTS];
+            blocks[block].store(events, std::memory_order_release);
+        }
+        
+        events[n % TraceLog::BLOCK_EVENTS] = event;
+        count.store(n + 1, std::memory_order_release);
+    }
+    
+    const Event& at(size_t index) const {
+        return blocks[index / TraceLog::BLOCK_EVENTS].load(std::memory_order_acquire)[index % TraceLog::BLOCK_EVENTS];
+    }
+};
+
+// Все буферы (в том числе завершившихся потоков) и начало отсчета времени
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    Clock::time_point epoch = Clock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// Имя и буфер потока; буфер создается при первом событии
+thread_local std::string threadName;
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+ThreadBuffer& localBuffer() {
+    if (!threadBuffer) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        
+        r.buffers.push_back(std::make_unique<ThreadBuffer>());
+        threadBuffer = r.buffers.back().get();
+        threadBuffer->tid = static_cast<uint32_t>(r.buffers.size());
+        threadBuffer->name = threadName.empty() ? "thread-" + std::to_string(threadBuffer->tid) : threadName;
+    }
+    
+    return *threadBuffer;
+}
+
+// Микросекунды от начала отсчета (единица времени формата)
+double micros(Clock::time_point time, Clock::time_point epoch) {
+    return std::chrono::duration<double, std::micro>(time - epoch).count();
+}
+
+// Экранирование имени потока для JSON
+std::string jsonEscape(const std::string& text) {
+    std::string result;
+    
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    
+    return result;
+}
+
+}
+
+std::atomic<bool> TraceLog::active{false};
+
+void TraceLog::enable(bool on) {
+    // Начало отсчета фиксируется до первого события
+    registry();
+    active.store(on, std::memory_order_relaxed);
+}
+
+void TraceLog::setThreadName(const std::string& name) {
+    threadName = name;
+}
+
+void TraceLog::complete(const char* name, const char* category, Clock::time_point begin, Clock::time_point end,
+                        uint64_t bytes, const char* kernel) {
+    if (!enabled()) {
+        return;
+    }
+    
+    localBuffer().append({name, category, kernel, bytes, begin, end});
+}
+
+bool TraceLog::write(const std::string& path) {
+    std::ofstream out(path);
+    
+    if (!out) {
+        return false;
+    }
+    
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    uint64_t dropped = 0;
+    bool first = true;
+    
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    
+    for (const auto& buffer : r.buffers) {
+        // Метаданные: имя потока на шкале
+        out << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+            << ", \"args\": {\"name\": \"" << jsonEscape(buffer->name) << "\"}}";
+        first = false;
+        
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+        
+        for (size_t i = 0; i < count; i++) {
+            const Event& event = buffer->at(i);
+            
+            out << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+                << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->tid
+                << ", \"ts\": " << micros(event.begin, r.epoch) << ", \"dur\": " << micros(event.end, event.begin)
+                << ", \"args\": {\"bytes\": " << event.bytes;
+            
+            if (event.kernel) {
+                out << ", \"kernel\": \"" << event.kernel << "\"";
+            }
+            
+            out << "}}";
+        }
+    }
+    
+    out << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+    out.close();
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,70 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Трассировка во времени в формате Chrome trace event (chrome://tracing, Perfetto):
+// для каждого фрагмента и стадии записывается интервал начало-конец в буфер своего потока.
+// Буфер пишет только его поток, без блокировок; чтение при записи в файл безопасно
+// и во время работы других потоков. По умолчанию выключена: интервал стоит одной проверки флага
+class TraceLog {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    // Буфер потока растет блоками по BLOCK_EVENTS событий, не более MAX_BLOCKS блоков;
+    // события сверх этого отбрасываются и подсчитываются
+    static const size_t BLOCK_EVENTS = 4096;
+    static const size_t MAX_BLOCKS = 256;
+    
+    // Включение и выключение записи (записанные события сохраняются)
+    static void enable(bool on);
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    
+    // Имя текущего потока на временной шкале (можно задать до включения трассировки)
+    static void setThreadName(const std::string& name);
+    
+    // Запись завершенного интервала; kernel - имя векторного ядра (для стадий шифрования).
+    // name, category и kernel - строки со статическим временем жизни (литералы):
+    // они сохраняются указателями до записи в файл
+    static void complete(const char* name, const char* category, Clock::time_point begin, Clock::time_point end,
+                         uint64_t bytes = 0, const char* kernel = nullptr);
+    
+    // Запись всех буферов в JSON; false при ошибке записи
+    static bool write(const std::string& path);
+    
+    // Интервал в пределах области видимости
+    class Span {
+    public:
+        Span(const char* name, const char* category, uint64_t bytes = 0, const char* kernel = nullptr)
+            : name(name), category(category), kernel(kernel), bytes(bytes), running(enabled()) {
+            if (running) {
+                start = Clock::now();
+            }
+        }
+        
+        ~Span() {
+            if (running) {
+                complete(name, category, start, Clock::now(), bytes, kernel);
+            }
+        }
+        
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+    
+    private:
+        const char* name;
+        const char* category;
+        const char* kernel;
+        uint64_t bytes;
+        bool running;
+        Clock::time_point start;
+    };
+
+private:
+    static std::atomic<bool> active;
+};
+
+#endif
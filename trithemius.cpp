@@ -1,4 +1,8 @@
 #include "../include/trithemius.h"
+#include "../include/trithemius_simd.h"
+#include "../include/kernel_registry.h"
+#include "../include/thread_pool.h"
+#include "../include/trace_log.h"
 #include <stdexcept>
 #include <sstream>
 
@@ -40,9 +44,22 @@ TrithemiusCipher::ProgressiveKey TrithemiusCipher::parseKey(const std::string& k
     return pk;
 }
 
-uint8_t TrithemiusCipher::encryptByte(uint8_t byte, int position, const ProgressiveKey& pk) const {
-    // Вычисление сдвига по формуле k(p) = ap + b + c
-    int shift = (pk.a * position + pk.b + pk.c) % 256;
+TrithemiusCipher::ShiftTable TrithemiusCipher::buildShiftTable(const ProgressiveKey& pk) const {
+    ShiftTable table;
+    
+    for (int p = 0; p < 256; p++) {
+        table[p] = encryptByte(0, static_cast<uint64_t>(p), pk);
+        table[p + 256] = table[p];
+    }
+    
+    return table;
+}
+
+uint8_t TrithemiusCipher::encryptByte(uint8_t byte, uint64_t position, const ProgressiveKey& pk) const {
+    // Вычисление сдвига по формуле k(p) = ap + b + c (по модулю 256).
+    // Каждое слагаемое приводится заранее, поэтому переполнения нет при любой позиции
+    int64_t shift = (static_cast<int64_t>(pk.a % 256) * static_cast<int64_t>(position % 256) +
+                     pk.b % 256 + pk.c % 256) % 256;
     
     // Приведение shift к положительному значению
     if (shift < 0) {
@@ -50,14 +67,15 @@ uint8_t TrithemiusCipher::encryptByte(uint8_t byte, int position, const Progress
     }
     
     // Шифрование с циклическим сдвигом
-    int encrypted = (static_cast<int>(byte) + shift) % 256;
+    int encrypted = (static_cast<int>(byte) + static_cast<int>(shift)) % 256;
     
     return static_cast<uint8_t>(encrypted);
 }
 
-uint8_t TrithemiusCipher::decryptByte(uint8_t byte, int position, const ProgressiveKey& pk) const {
-    // Вычисление сдвига по формуле k(p) = ap + b + c
-    int shift = (pk.a * position + pk.b + pk.c) % 256;
+uint8_t TrithemiusCipher::decryptByte(uint8_t byte, uint64_t position, const ProgressiveKey& pk) const {
+    // Вычисление сдвига по формуле k(p) = ap + b + c (по модулю 256)
+    int64_t shift = (static_cast<int64_t>(pk.a % 256) * static_cast<int64_t>(position % 256) +
+                     pk.b % 256 + pk.c % 256) % 256;
     
     // Приведение shift к положительному значению
     if (shift < 0) {
@@ -65,11 +83,77 @@ uint8_t TrithemiusCipher::decryptByte(uint8_t byte, int position, const Progress
     }
     
     // Дешифрование с циклическим сдвигом
-    int decrypted = (static_cast<int>(byte) - shift + 256) % 256;
+    int decrypted = (static_cast<int>(byte) - static_cast<int>(shift) + 256) % 256;
     
     return static_cast<uint8_t>(decrypted);
 }
 
+void TrithemiusCipher::processData(const uint8_t* input, uint8_t* output, size_t length,
+                                   uint64_t position, const ShiftTable& table, bool decrypt) const {
+    // Большой объем делится на фрагменты для общего пула потоков: сдвиг зависит только от позиции
+    if (length > PARALLEL_CHUNK && ThreadPool::shared().size() > 1) {
+        ThreadPool::shared().parallelRange(length, PARALLEL_CHUNK, [&](size_t begin, size_t end) {
+            processData(input + begin, output + begin, end - begin, position + begin, table, decrypt);
+        });
+        return;
+    }
+    
+    // Векторная часть
+    const int kernel = KernelRegistry::selected(KernelRegistry::Trithemius);
+    TraceLog::Span span("trithemius", "kernel", length, KernelRegistry::kernels(KernelRegistry::Trithemius)[kernel].name);
+    size_t done = TrithemiusSimd::apply(kernel, input, output, length, position, table.data(), decrypt);
+    
+    // Хвост (или все данные без векторных ядер)
+    for (size_t i = done; i < length; i++) {
+        uint8_t shift = table[(position + i) % 256];
+        output[i] = decrypt ? static_cast<uint8_t>(input[i] - shift) : static_cast<uint8_t>(input[i] + shift);
+    }
+}
+
+bool TrithemiusCipher::verifyKernel(int kernel) {
+    TrithemiusCipher reference;
+    
+    // Отрицательный коэффициент и фаза, не кратная ширине ядер
+    const ProgressiveKey pk = {-7, 3, 250};
+    const uint64_t position = 1000003;
+    ShiftTable table = reference.buildShiftTable(pk);
+    
+    uint8_t plain[SELF_TEST_SIZE];
+    uint8_t encrypted[SELF_TEST_SIZE];
+    uint8_t decrypted[SELF_TEST_SIZE];
+    
+    for (size_t i = 0; i < SELF_TEST_SIZE; i++) {
+        plain[i] = static_cast<uint8_t>(i * 151 + 3);
+    }
+    
+    size_t encryptedBytes = SELF_TEST_SIZE;
+    size_t decryptedBytes = SELF_TEST_SIZE;
+    
+    if (kernel == TrithemiusSimd::Scalar) {
+        for (size_t i = 0; i < SELF_TEST_SIZE; i++) {
+            uint8_t shift = table[(position + i) % 256];
+            encrypted[i] = static_cast<uint8_t>(plain[i] + shift);
+            decrypted[i] = static_cast<uint8_t>(encrypted[i] - shift);
+        }
+    } else {
+        encryptedBytes = TrithemiusSimd::apply(kernel, plain, encrypted, SELF_TEST_SIZE, position, table.data(), false);
+        decryptedBytes = TrithemiusSimd::apply(kernel, encrypted, decrypted, SELF_TEST_SIZE, position, table.data(), true);
+    }
+    
+    if (encryptedBytes != SELF_TEST_SIZE || decryptedBytes != SELF_TEST_SIZE) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < SELF_TEST_SIZE; i++) {
+        if (encrypted[i] != reference.encryptByte(plain[i], position + i, pk) ||
+            decrypted[i] != reference.decryptByte(encrypted[i], position + i, pk)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
 bool TrithemiusCipher::validateKey(const std::string& key) const {
     try {
         parseKey(key);
@@ -79,38 +163,120 @@ bool TrithemiusCipher::validateKey(const std::string& key) const {
     }
 }
 
-std::vector<uint8_t> TrithemiusCipher::encryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
-    ProgressiveKey pk = parseKey(key);
-    std::vector<uint8_t> result;
-    result.reserve(data.size());
+PreparedKeyPtr TrithemiusCipher::prepareKey(const std::string& key) const {
+    auto prepared = std::make_shared<Key>();
+    prepared->table = buildShiftTable(parseKey(key));
+    return prepared;
+}
+
+const TrithemiusCipher::Key& TrithemiusCipher::preparedKey(const PreparedKey& key) {
+    const Key* prepared = dynamic_cast<const Key*>(&key);
     
-    for (size_t i = 0; i < data.size(); i++) {
-        result.push_back(encryptByte(data[i], static_cast<int>(i), pk));
+    if (!prepared) {
+        throw std::invalid_argument("Ключ подготовлен не для шифра Тритемиуса");
     }
     
+    return *prepared;
+}
+
+std::vector<uint8_t> TrithemiusCipher::encryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
+    return encryptBytes(data, *prepareKey(key));
+}
+
+std::vector<uint8_t> TrithemiusCipher::encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) {
+    std::vector<uint8_t> result(data.size());
+    encryptBytes(data.data(), data.size(), result.data(), key);
+    
     return result;
 }
 
+size_t TrithemiusCipher::encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) {
+    processData(input, output, length, 0, preparedKey(key).table, false);
+    return length;
+}
+
 std::vector<uint8_t> TrithemiusCipher::decryptBytes(const std::vector<uint8_t>& data, const std::string& key) {
-    ProgressiveKey pk = parseKey(key);
-    std::vector<uint8_t> result;
-    result.reserve(data.size());
+    return decryptBytes(data, *prepareKey(key));
+}
+
+std::vector<uint8_t> TrithemiusCipher::decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) {
+    std::vector<uint8_t> result(data.size());
+    decryptBytes(data.data(), data.size(), result.data(), key);
     
-    for (size_t i = 0; i < data.size(); i++) {
-        result.push_back(decryptByte(data[i], static_cast<int>(i), pk));
+    return result;
+}
+
+size_t TrithemiusCipher::decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) {
+    processData(input, output, length, 0, preparedKey(key).table, true);
+    return length;
+}
+
+// Потоковый контекст Тритемиуса: между вызовами переносится позиция в потоке
+class TrithemiusCipher::Stream : public ICipherStream {
+public:
+    explicit Stream(const TrithemiusCipher& settings) : cipher(settings) {}
+    
+    void begin(const std::string& key, bool encrypt) override {
+        begin(*cipher.prepareKey(key), encrypt);
     }
     
-    return result;
+    void begin(const PreparedKey& key, bool encrypt) override {
+        table = preparedKey(key).table;
+        decrypting = !encrypt;
+        position = 0;
+        started = true;
+    }
+    
+    size_t update(const uint8_t* input, size_t length, uint8_t* output) override {
+        if (!started) {
+            throw std::logic_error("Поток не инициализирован: требуется begin");
+        }
+        
+        cipher.processData(input, output, length, position, table, decrypting);
+        position += length;
+        return length;
+    }
+    
+    size_t finish(uint8_t*) override {
+        if (!started) {
+            throw std::logic_error("Поток не инициализирован: требуется begin");
+        }
+        
+        started = false;
+        return 0;
+    }
+    
+    size_t updateOutputSize(size_t length) const override { return length; }
+    size_t finishOutputSize() const override { return 0; }
+
+private:
+    TrithemiusCipher cipher;
+    ShiftTable table{};
+    uint64_t position = 0;
+    bool decrypting = false;
+    bool started = false;
+};
+
+std::unique_ptr<ICipherStream> TrithemiusCipher::createStream() const {
+    return std::make_unique<Stream>(*this);
 }
 
 std::string TrithemiusCipher::encrypt(const std::string& plaintext, const std::string& key) {
+    return encrypt(plaintext, *prepareKey(key));
+}
+
+std::string TrithemiusCipher::encrypt(const std::string& plaintext, const PreparedKey& key) {
     std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
     std::vector<uint8_t> encrypted = encryptBytes(data, key);
-    return std::string(encrypted.begin(), encrypted.end());
+    return TextCodec::encode(encrypted, textEncoding);
 }
 
 std::string TrithemiusCipher::decrypt(const std::string& ciphertext, const std::string& key) {
-    std::vector<uint8_t> data(ciphertext.begin(), ciphertext.end());
+    return decrypt(ciphertext, *prepareKey(key));
+}
+
+std::string TrithemiusCipher::decrypt(const std::string& ciphertext, const PreparedKey& key) {
+    std::vector<uint8_t> data = TextCodec::decode(ciphertext, textEncoding);
     std::vector<uint8_t> decrypted = decryptBytes(data, key);
     return std::string(decrypted.begin(), decrypted.end());
 }
\ No newline at end of file
@@ -2,10 +2,20 @@
 #define TRITHEMIUS_H
 
 #include "cipher_interface.h"
+#include <array>
 
 // Реализация шифра Тритемиуса с прогрессивным ключом
 class TrithemiusCipher : public ICipher {
 private:
+    // Размер фрагмента параллельной обработки (в пределах кэша L2)
+    static const size_t PARALLEL_CHUNK = 256 * 1024;
+    
+    // Размер данных самопроверки ядер: кратен ширине всех векторных ядер
+    static const size_t SELF_TEST_SIZE = 1024;
+    
+    // Представление шифртекста в текстовом режиме (по умолчанию - байты как есть)
+    TextEncoding textEncoding = TextEncoding::Raw;
+    
     // Параметры линейной функции k(p) = ap + b + c
     struct ProgressiveKey {
         int a;
@@ -16,20 +26,59 @@ private:
     // Парсинг ключа из строки формата "a,b,c"
     ProgressiveKey parseKey(const std::string& key) const;
     
+    // Таблица сдвигов k(p) mod 256: период по p равен 256, таблица удвоена,
+    // чтобы окно любой ширины до 256 байт с любой фазы было непрерывным
+    using ShiftTable = std::array<uint8_t, 512>;
+    
+    // Построение таблицы сдвигов для ключа (один раз на ключ)
+    ShiftTable buildShiftTable(const ProgressiveKey& pk) const;
+    
+    // Подготовленный ключ: таблица сдвигов
+    struct Key : PreparedKey {
+        ShiftTable table;
+    };
+    
+    // Проверка, что ключ подготовлен шифром Тритемиуса
+    static const Key& preparedKey(const PreparedKey& key);
+    
     // Шифрование одного байта с позицией
-    uint8_t encryptByte(uint8_t byte, int position, const ProgressiveKey& pk) const;
+    uint8_t encryptByte(uint8_t byte, uint64_t position, const ProgressiveKey& pk) const;
     
     // Дешифрование одного байта с позицией
-    uint8_t decryptByte(uint8_t byte, int position, const ProgressiveKey& pk) const;
+    uint8_t decryptByte(uint8_t byte, uint64_t position, const ProgressiveKey& pk) const;
+    
+    // Обработка данных по таблице; position - позиция первого байта в потоке. Допускается input == output
+    void processData(const uint8_t* input, uint8_t* output, size_t length,
+                     uint64_t position, const ShiftTable& table, bool decrypt) const;
+    
+    // Потоковый контекст (определен в trithemius.cpp)
+    class Stream;
 
 public:
     std::string encrypt(const std::string& plaintext, const std::string& key) override;
     std::string decrypt(const std::string& ciphertext, const std::string& key) override;
     std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const std::string& key) override;
     std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const std::string& key) override;
+    PreparedKeyPtr prepareKey(const std::string& key) const override;
+    std::string encrypt(const std::string& plaintext, const PreparedKey& key) override;
+    std::string decrypt(const std::string& ciphertext, const PreparedKey& key) override;
+    std::vector<uint8_t> encryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) override;
+    std::vector<uint8_t> decryptBytes(const std::vector<uint8_t>& data, const PreparedKey& key) override;
+    size_t encryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) override;
+    size_t decryptBytes(const uint8_t* input, size_t length, uint8_t* output, const PreparedKey& key) override;
+    size_t encryptedSize(size_t length) const override { return length; }
+    size_t decryptedSize(size_t length) const override { return length; }
     std::string getName() const override { return "Шифр Тритемиуса"; }
     std::string getKeyFormat() const override { return "Три числа через запятую: a,b,c (например: 1,2,3)"; }
     bool validateKey(const std::string& key) const override;
+    std::unique_ptr<ICipherStream> createStream() const override;
+    bool supportsStreaming() const override { return true; }
+    void setTextEncoding(TextEncoding encoding) override { textEncoding = encoding; }
+    TextEncoding getTextEncoding() const override { return textEncoding; }
+    
+    // Самопроверка ядра TrithemiusSimd::Kernel (для KernelRegistry): результат
+    // должен совпасть с encryptByte/decryptByte; Scalar проверяет таблицу сдвигов
+    static bool verifyKernel(int kernel);
 };
 
 #endif
\ No newline at end of file
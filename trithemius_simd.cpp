@@ -0,0 +1,69 @@
+#include "../include/trithemius_simd.h"
+#include "../include/cpu_features.h"
+
+#ifdef RGR_X86_SIMD
+    #include <immintrin.h>
+#endif
+
+size_t TrithemiusSimd::apply(int kernel, const uint8_t* input, uint8_t* output, size_t length,
+                             uint64_t position, const uint8_t* table, bool subtract) {
+    switch (kernel) {
+        case Avx2:
+            return applyAvx2(input, output, length, position, table, subtract);
+        case Sse2:
+            return applySse2(input, output, length, position, table, subtract);
+        default:
+            return 0;
+    }
+}
+
+#ifdef RGR_X86_SIMD
+
+__attribute__((target("sse2")))
+size_t TrithemiusSimd::applySse2(const uint8_t* input, uint8_t* output, size_t length,
+                                 uint64_t position, const uint8_t* table, bool subtract) {
+    size_t processed = length - length % SSE2_WIDTH;
+    // Фаза в таблице; благодаря удвоению окно всегда непрерывно
+    size_t phase = static_cast<size_t>(position % 256);
+    
+    for (size_t i = 0; i < processed; i += SSE2_WIDTH) {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i shift = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + phase));
+        __m128i result = subtract ? _mm_sub_epi8(data, shift) : _mm_add_epi8(data, shift);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), result);
+        
+        phase = (phase + SSE2_WIDTH) & 0xFF;
+    }
+    
+    return processed;
+}
+
+__attribute__((target("avx2")))
+size_t TrithemiusSimd::applyAvx2(const uint8_t* input, uint8_t* output, size_t length,
+                                 uint64_t position, const uint8_t* table, bool subtract) {
+    size_t processed = length - length % AVX2_WIDTH;
+    size_t phase = static_cast<size_t>(position % 256);
+    
+    for (size_t i = 0; i < processed; i += AVX2_WIDTH) {
+        __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i shift = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + phase));
+        __m256i result = subtract ? _mm256_sub_epi8(data, shift) : _mm256_add_epi8(data, shift);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), result);
+        
+        phase = (phase + AVX2_WIDTH) & 0xFF;
+    }
+    
+    return processed;
+}
+
+#else
+
+size_t TrithemiusSimd::applySse2(const uint8_t*, uint8_t*, size_t, uint64_t, const uint8_t*, bool) {
+    return 0;
+}
+
+size_t TrithemiusSimd::applyAvx2(const uint8_t*, uint8_t*, size_t, uint64_t, const uint8_t*, bool) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef TRITHEMIUS_SIMD_H
+#define TRITHEMIUS_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Векторные ядра шифра Тритемиуса: к данным прибавляется (или вычитается)
+// окно таблицы сдвигов по 16 (SSE2) или 32 (AVX2) байта за операцию
+class TrithemiusSimd {
+public:
+    // Ядра по возрастанию ширины; значения - индексы в KernelRegistry
+    enum Kernel {
+        Scalar,     // векторного ядра нет, данные обрабатываются по таблице побайтно
+        Sse2,
+        Avx2
+    };
+    
+    // Байт за итерацию ядра
+    static const int SSE2_WIDTH = 16;
+    static const int AVX2_WIDTH = 32;
+    
+    // Обработка данных заданным ядром (процессор должен его поддерживать).
+    // table - удвоенная таблица сдвигов (512 байт, период 256), position - позиция первого байта.
+    // Возвращает число обработанных байт (кратно ширине ядра, 0 для Scalar), хвост остается вызывающему
+    static size_t apply(int kernel, const uint8_t* input, uint8_t* output, size_t length,
+                        uint64_t position, const uint8_t* table, bool subtract);
+
+private:
+    static size_t applySse2(const uint8_t* input, uint8_t* output, size_t length,
+                            uint64_t position, const uint8_t* table, bool subtract);
+    
+    static size_t applyAvx2(const uint8_t* input, uint8_t* output, size_t length,
+                            uint64_t position, const uint8_t* table, bool subtract);
+};
+
+#endif